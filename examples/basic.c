@@ -11,6 +11,8 @@
 #include "pico/stdlib.h"
 
 int main(void) {
+    stdio_init_all();
+
     vfd_error_t err = vfd_init(NULL);
     if (err != VFD_OK) {
         printf("VFD initialization failed: %s\n", vfd_strerror(err));
@@ -0,0 +1,261 @@
+/**
+ * @file benchmark.c
+ * @brief Repeatable refresh benchmark across all backends and SPI rates
+ *
+ * Runs every refresh engine (blocking vfd_refresh(), timer IRQ, core 1 and
+ * PIO + DMA) at several SPI baud rates and prints one CSV line per run over
+ * USB stdio:
+ *
+ *   bench,<backend>,<baud>,<fps>,<slot_min_us>,<slot_max_us>,<jitter_us>,
+ *         <cpu0_pct>,<latency_avg_us>,<latency_max_us>,<missed>
+ *
+ * Frame rate and slot jitter are taken from the LOAD pin itself: its pad
+ * input still works while SPI/PIO drive it, so a GPIO edge interrupt
+ * timestamps every latch on the wire. Core 0 utilisation comes from an
+ * idle-loop counter compared against a calibration run with the display
+ * stopped. Latency (vfd_write_* + vfd_commit() to the frame that shows it)
+ * and missed deadlines need MAX6921_STATS=1; fields that cannot be measured
+ * in a given run print -1.
+ *
+ * Lines starting with '#' are comments; "done" marks the end of a pass.
+ */
+
+#include "max6921.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+
+#define BENCH_WINDOW_US 1000000u   /* Length of each measurement window */
+#define BENCH_SETTLE_MS 50         /* Let the engine run before measuring */
+#define BENCH_LATENCY_SAMPLES 16
+
+/* Tube under test; every grid is lit, so each frame scans all of them */
+#ifndef BENCH_GRIDS
+#define BENCH_GRIDS 9
+#endif
+
+typedef enum {
+    BENCH_BLOCKING,
+    BENCH_TIMER,
+    BENCH_CORE1,
+    BENCH_PIO_DMA
+} bench_backend_t;
+
+static const char *const BACKEND_NAMES[] = {"blocking", "timer", "core1", "pio_dma"};
+
+static const uint32_t BAUD_RATES[] = {1000000, 2000000, 4000000, 8000000};
+
+/* Latch edge capture, written by the GPIO IRQ */
+static volatile uint32_t g_edges;
+static volatile uint32_t g_slot_min_us;
+static volatile uint32_t g_slot_max_us;
+static uint32_t g_edges_per_slot;
+static uint32_t g_slot_start_us;
+
+static void on_latch_edge(uint gpio, uint32_t events) {
+    (void)gpio;
+    (void)events;
+    uint32_t now = time_us_32();
+
+    g_edges++;
+    if (g_edges % g_edges_per_slot != 0) {
+        return;
+    }
+    if (g_slot_start_us != 0) {
+        uint32_t slot = now - g_slot_start_us;
+        if (slot < g_slot_min_us) {
+            g_slot_min_us = slot;
+        }
+        if (slot > g_slot_max_us) {
+            g_slot_max_us = slot;
+        }
+    }
+    g_slot_start_us = now;
+}
+
+static void capture_start(uint8_t pin_latch, uint32_t edges_per_slot) {
+    g_edges = 0;
+    g_slot_min_us = UINT32_MAX;
+    g_slot_max_us = 0;
+    g_edges_per_slot = edges_per_slot;
+    g_slot_start_us = 0;
+    gpio_set_irq_enabled_with_callback(pin_latch, GPIO_IRQ_EDGE_RISE, true, on_latch_edge);
+}
+
+static void capture_stop(uint8_t pin_latch) {
+    gpio_set_irq_enabled(pin_latch, GPIO_IRQ_EDGE_RISE, false);
+}
+
+/* Spin for one window and return how many iterations core 0 managed */
+static uint32_t idle_loop(uint32_t window_us) {
+    uint32_t count = 0;
+    uint32_t start = time_us_32();
+    while (time_us_32() - start < window_us) {
+        count++;
+    }
+    return count;
+}
+
+/* Average and worst time from write + commit until the engine latches it
+ * Uses the stats frame counter, which advances as the new frame's grid 0
+ * goes out. Returns false if stats are not compiled in, and for DMA, which
+ * has no CPU-visible frame boundary (its latency is at most one frame).
+ */
+static bool measure_latency(bench_backend_t backend, uint32_t *avg_us, uint32_t *max_us) {
+    vfd_stats_t stats;
+    if (vfd_get_stats(&stats) != VFD_OK || backend == BENCH_PIO_DMA) {
+        return false;
+    }
+
+    uint64_t total = 0;
+    uint32_t worst = 0;
+    for (uint8_t i = 0; i < BENCH_LATENCY_SAMPLES; i++) {
+        uint64_t start = time_us_64();
+        vfd_write_digit(0, i % 10);
+
+        if (backend == BENCH_BLOCKING) {
+            /* Grid 0 is the first burst; the rest of the call is the frame */
+            vfd_reset_stats();
+            vfd_refresh();
+            vfd_get_stats(&stats);
+            uint32_t latency = (uint32_t)(time_us_64() - start) - stats.frame_us_max;
+            total += latency;
+            worst = (latency > worst) ? latency : worst;
+            continue;
+        }
+
+        vfd_get_stats(&stats);
+        uint32_t frames = stats.frames;
+        vfd_commit();
+        do {
+            vfd_get_stats(&stats);
+        } while (stats.frames == frames);
+
+        uint32_t latency = (uint32_t)(time_us_64() - start);
+        total += latency;
+        worst = (latency > worst) ? latency : worst;
+    }
+
+    *avg_us = (uint32_t)(total / BENCH_LATENCY_SAMPLES);
+    *max_us = worst;
+    return true;
+}
+
+static vfd_error_t start_backend(bench_backend_t backend) {
+    switch (backend) {
+    case BENCH_TIMER:
+    case BENCH_PIO_DMA:
+        return vfd_start_autorefresh();
+    case BENCH_CORE1:
+        return vfd_launch_core1();
+    default:
+        return VFD_OK;
+    }
+}
+
+static void run_one(bench_backend_t backend, uint32_t baud, uint32_t idle_baseline) {
+    vfd_config_t config = vfd_default_config();
+    config.spi_baudrate = baud;
+    config.grids = BENCH_GRIDS;
+    if (backend == BENCH_PIO_DMA) {
+        config.backend = VFD_BACKEND_PIO;
+    }
+
+    vfd_error_t err = vfd_init(&config);
+    if (err == VFD_OK) {
+        err = start_backend(backend);
+    }
+    if (err != VFD_OK) {
+        printf("# %s @ %lu: %s\n", BACKEND_NAMES[backend], (unsigned long)baud, vfd_strerror(err));
+        vfd_deinit();
+        return;
+    }
+
+    /* Full brightness: one latch per slot, or lit + blank word on PIO */
+    vfd_set_brightness(VFD_BRIGHTNESS_MAX);
+    vfd_fill_buffer(VFD_DIGIT_8 | VFD_SYMBOL_DOT);
+    vfd_refresh();
+    sleep_ms(BENCH_SETTLE_MS);
+    vfd_reset_stats();
+
+    /* Window 1: frame rate and slot jitter from the latch pin */
+    uint32_t edges_per_slot = (backend == BENCH_PIO_DMA) ? 2 : 1;
+    capture_start(config.pin_latch, edges_per_slot);
+    uint32_t start = time_us_32();
+    if (backend == BENCH_BLOCKING) {
+        while (time_us_32() - start < BENCH_WINDOW_US) {
+            vfd_refresh();
+        }
+    } else {
+        sleep_us(BENCH_WINDOW_US);
+    }
+    uint32_t elapsed = time_us_32() - start;
+    capture_stop(config.pin_latch);
+
+    uint64_t millifps = ((uint64_t)g_edges * 1000000000ull) /
+                        ((uint64_t)elapsed * config.grids * edges_per_slot);
+    uint32_t slot_min = (g_slot_max_us != 0) ? g_slot_min_us : 0;
+    uint32_t slot_max = g_slot_max_us;
+
+    /* Window 2: core 0 left over; the blocking loop uses all of it */
+    uint32_t cpu_pct = 100;
+    if (backend != BENCH_BLOCKING) {
+        uint32_t idle = idle_loop(BENCH_WINDOW_US);
+        cpu_pct = (idle >= idle_baseline) ? 0 :
+                  (uint32_t)(100u - ((uint64_t)idle * 100u) / idle_baseline);
+    }
+
+    int32_t missed = -1;
+    vfd_stats_t stats;
+    if (vfd_get_stats(&stats) == VFD_OK && backend != BENCH_BLOCKING &&
+        backend != BENCH_PIO_DMA) {
+        missed = (int32_t)stats.missed_deadlines;
+    }
+
+    uint32_t lat_avg = 0;
+    uint32_t lat_max = 0;
+    bool have_latency = measure_latency(backend, &lat_avg, &lat_max);
+
+    printf("bench,%s,%lu,%lu.%03lu,%lu,%lu,%lu,%lu,%ld,%ld,%ld\n",
+           BACKEND_NAMES[backend], (unsigned long)baud,
+           (unsigned long)(millifps / 1000), (unsigned long)(millifps % 1000),
+           (unsigned long)slot_min, (unsigned long)slot_max,
+           (unsigned long)(slot_max - slot_min), (unsigned long)cpu_pct,
+           have_latency ? (long)lat_avg : -1L, have_latency ? (long)lat_max : -1L,
+           (long)missed);
+
+    vfd_deinit();
+}
+
+int main(void) {
+    stdio_init_all();
+
+    /* Give the USB host time to open the port */
+    sleep_ms(2000);
+
+    /* Idle iterations per window with nothing but stdio running */
+    uint32_t idle_baseline = idle_loop(BENCH_WINDOW_US);
+
+    vfd_stats_t probe;
+    vfd_init(NULL);
+    bool have_stats = vfd_get_stats(&probe) == VFD_OK;
+    vfd_deinit();
+
+    while (true) {
+        printf("# max6921 benchmark, window %lu us, stats %s\n",
+               (unsigned long)BENCH_WINDOW_US, have_stats ? "on" : "off");
+        printf("# bench,backend,baud,fps,slot_min_us,slot_max_us,jitter_us,"
+               "cpu0_pct,latency_avg_us,latency_max_us,missed\n");
+
+        for (uint8_t b = 0; b < count_of(BACKEND_NAMES); b++) {
+            for (uint8_t r = 0; r < count_of(BAUD_RATES); r++) {
+                run_one((bench_backend_t)b, BAUD_RATES[r], idle_baseline);
+            }
+        }
+
+        printf("done\n");
+        sleep_ms(5000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file fixed_board.cpp
+ * @brief C++ front-end on a board with fixed pins and tube
+ *
+ * The board is a type: pins, SPI block and grid count are checked by the
+ * compiler, and the greeting and the spinner animation are encoded at
+ * compile time into const tables in flash. The greeting doubles as the
+ * boot frame, on the tube as soon as init returns. Build with C++20.
+ */
+
+#include "max6921.hpp"
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+using Board = max6921::Vfd<1, max6921::Pins{}, 9>;
+
+static constexpr Board::Patterns greeting = Board::text("HELLO");
+static constexpr auto spinner_frames = Board::frames({"-", " -", "  -", "   -"}, 150);
+static constexpr vfd_animation_t spinner = Board::animation(spinner_frames, true);
+
+static Board vfd;
+
+int main(void) {
+    /* The greeting is scanning when init returns; USB stdio comes up after */
+    vfd_config_t config = vfd_default_config();
+    config.boot_frame = greeting.data();
+    vfd_error_t err = vfd.init(config);
+
+    stdio_init_all();
+    if (err != VFD_OK) {
+        printf("VFD initialization failed: %s\n", vfd_strerror(err));
+        return 1;
+    }
+    sleep_ms(2000);
+
+    vfd.play(spinner);
+    sleep_ms(3000);
+    vfd_stop_animation_ex(vfd.handle());
+
+    char line[16];
+    for (uint32_t count = 0;; count++) {
+        snprintf(line, sizeof(line), "%8lu", (unsigned long)count);
+        vfd.print(line);
+        vfd.commit();
+        sleep_ms(100);
+    }
+}
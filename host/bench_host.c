@@ -0,0 +1,204 @@
+/**
+ * @file bench_host.c
+ * @brief Off-target benchmark of the driver against the simulated MAX6921
+ *
+ * Build and run (from the repository root):
+ *
+ *   cc -O2 -std=c11 -DMAX6921_HOST=1 -DMAX6921_STATS=1 -I. -Ihost \
+ *      max6921.c host/max6921_sim.c host/bench_host.c -o bench_host
+ *   ./bench_host
+ *
+ * Prints one CSV line per case:
+ *
+ *   host,<case>,<iterations>,<ns_per_iter>,<sim_us_per_iter>,<bus_us_per_iter>
+ *
+ * ns_per_iter is real host CPU time (encoder and scheduler throughput);
+ * the sim_ columns are virtual time on the simulated bus, i.e. what the
+ * same work would take on the wire. A final "check" line verifies that the
+ * latched outputs match what was written and that a one-grid tube holds
+ * its target frame rate; the exit status is non-zero if they do not.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "max6921.h"
+#include "max6921_sim.h"
+#include <stdio.h>
+#include <time.h>
+
+static uint64_t host_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void report(const char *name, uint32_t iterations, uint64_t ns,
+                   uint64_t sim_us, uint64_t bus_us) {
+    printf("host,%s,%u,%llu,%llu,%llu\n", name, iterations,
+           (unsigned long long)(ns / iterations),
+           (unsigned long long)(sim_us / iterations),
+           (unsigned long long)(bus_us / iterations));
+}
+
+static void bench_write_string(uint32_t iterations) {
+    static const char *const texts[] = {"12-34-56", "8.8.8.8.8.8.8.8.8.", "-1.234567"};
+
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vfd_write_string(texts[i % 3]);
+    }
+    report("write_string", iterations, host_ns() - start, 0, 0);
+}
+
+static void bench_commit(uint32_t iterations) {
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vfd_write_digit(i % 9, i % 10);
+        vfd_commit();
+    }
+    report("commit_one_grid", iterations, host_ns() - start, 0, 0);
+
+    /* A brightness change re-encodes every grid */
+    start = host_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vfd_set_brightness((uint8_t)(i % (VFD_BRIGHTNESS_MAX + 1)));
+        vfd_commit();
+    }
+    report("commit_all_grids", iterations, host_ns() - start, 0, 0);
+    vfd_set_brightness(VFD_BRIGHTNESS_MAX);
+}
+
+static void bench_blocking_refresh(uint32_t iterations) {
+    uint64_t sim_start = max6921_sim_time_us();
+    uint64_t bus_start = max6921_sim_bus_time_us();
+
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vfd_refresh();
+    }
+    report("refresh_blocking", iterations, host_ns() - start,
+           max6921_sim_time_us() - sim_start, max6921_sim_bus_time_us() - bus_start);
+}
+
+/* One simulated second of the timer engine per iteration */
+static void bench_timer_engine(uint32_t iterations) {
+    if (vfd_start_autorefresh() != VFD_OK) {
+        printf("# timer engine unavailable\n");
+        return;
+    }
+
+    uint64_t sim_start = max6921_sim_time_us();
+    uint64_t bus_start = max6921_sim_bus_time_us();
+    uint32_t latch_start = max6921_sim_latch_count();
+
+    uint64_t start = host_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        max6921_sim_run_for(1000000);
+    }
+    uint64_t ns = host_ns() - start;
+    vfd_stop_autorefresh();
+
+    report("timer_engine_1s", iterations, ns,
+           max6921_sim_time_us() - sim_start, max6921_sim_bus_time_us() - bus_start);
+    printf("# timer engine: %u latches/s\n",
+           (max6921_sim_latch_count() - latch_start) / iterations);
+}
+
+/* Latched outputs must match the buffer, grid by grid */
+static bool check_outputs(void) {
+    vfd_write_string("01234567.8");
+    vfd_refresh();
+
+    uint32_t last = max6921_sim_latch_count();
+    if (last < 9) {
+        return false;
+    }
+    for (uint8_t grid = 0; grid < 9; grid++) {
+        const max6921_sim_latch_t *entry = max6921_sim_latch(last - 9 + grid);
+        uint8_t segments;
+        vfd_read_segments(grid, &segments);
+        uint32_t expected = ((0x100u >> grid) << 8) | segments;
+        if (entry == NULL || entry->outputs[0] != expected) {
+            printf("# grid %u: latched 0x%05x, expected 0x%05x\n", grid,
+                   entry ? (unsigned)entry->outputs[0] : 0u, (unsigned)expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* A target rate on a one-grid tube: the slot is the whole frame, and a
+ * rate whose slot does not fit refresh_interval_us must be refused */
+static bool check_small_tube(void) {
+    max6921_sim_reset(1);
+
+    vfd_t vfd = {0};
+    vfd_config_t config = vfd_default_config();
+    config.grids = 1;
+    config.target_fps = 10;
+    if (vfd_init_ex(&vfd, &config) != VFD_ERR_INVALID_PARAM) {
+        printf("# 1 grid at 10 fps: slot should not fit\n");
+        return false;
+    }
+
+    config.target_fps = 20;
+    if (vfd_init_ex(&vfd, &config) != VFD_OK) {
+        printf("# 1 grid at 20 fps: init failed\n");
+        return false;
+    }
+    vfd_write_segments_ex(&vfd, 0, VFD_DIGIT_8);
+    vfd_commit_ex(&vfd);
+    vfd_start_autorefresh_ex(&vfd);
+    max6921_sim_run_for(5000);
+
+    /* Time from one lit latch to the next is the 50 ms frame */
+    uint32_t first = max6921_sim_latch_count();
+    max6921_sim_run_for(1000000);
+    uint32_t last = max6921_sim_latch_count();
+    uint64_t lit[2];
+    uint32_t found = 0;
+    for (uint32_t i = first; i < last && found < 2; i++) {
+        const max6921_sim_latch_t *entry = max6921_sim_latch(i);
+        if (entry != NULL && (entry->outputs[0] & 0xFF) != 0) {
+            lit[found++] = entry->time_us;
+        }
+    }
+    vfd_deinit_ex(&vfd);
+
+    if (found < 2 || lit[1] - lit[0] != 50000) {
+        printf("# 1 grid at 20 fps: frame %llu us, expected 50000\n",
+               found < 2 ? 0ull : (unsigned long long)(lit[1] - lit[0]));
+        return false;
+    }
+    return true;
+}
+
+int main(void) {
+    max6921_sim_reset(1);
+
+    vfd_error_t err = vfd_init(NULL);
+    if (err != VFD_OK) {
+        printf("# init failed: %s\n", vfd_strerror(err));
+        return 1;
+    }
+
+    printf("# host,case,iterations,ns_per_iter,sim_us_per_iter,bus_us_per_iter\n");
+    bench_write_string(100000);
+    bench_commit(100000);
+    bench_blocking_refresh(1000);
+    bench_timer_engine(10);
+
+    vfd_stats_t stats;
+    if (vfd_get_stats(&stats) == VFD_OK) {
+        printf("# stats: frames %u, frame %u/%u/%u us, spi %u us avg, missed %u\n",
+               stats.frames, stats.frame_us_min, stats.frame_us_avg, stats.frame_us_max,
+               stats.spi_us_avg, stats.missed_deadlines);
+    }
+
+    bool ok = check_outputs();
+    vfd_deinit();
+    ok = check_small_tube() && ok;
+    printf("check,%s\n", ok ? "pass" : "fail");
+
+    return ok ? 0 : 1;
+}
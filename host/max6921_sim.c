@@ -0,0 +1,495 @@
+/**
+ * @file max6921_sim.c
+ * @brief Simulated MAX6921 chain and virtual-time HAL for host builds
+ */
+
+#include "max6921_sim.h"
+#include "max6921_hal.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_ALARM_COUNT 4
+#define SIM_SPI_COUNT 2
+
+typedef struct {
+    bool active;
+    int32_t id;
+    uint64_t due_us;
+    max6921_hal_alarm_callback_t callback;
+    void *user_data;
+} sim_alarm_t;
+
+typedef struct {
+    uint64_t now_us;
+    uint8_t chain_length;
+    uint32_t baudrate[SIM_SPI_COUNT];
+    bool cs_latch[SIM_SPI_COUNT];
+    bool rx_routed[SIM_SPI_COUNT];
+    uint32_t dout_max_baud;
+    uint32_t dout;
+    uint32_t shift[VFD_CHAIN_MAX];
+    uint32_t outputs[VFD_CHAIN_MAX];
+    bool pin_state[32];
+    uint64_t bits;
+    uint64_t bus_time_us;
+    uint32_t latches;
+    max6921_sim_latch_t log[MAX6921_SIM_LOG_SIZE];
+    sim_alarm_t alarms[SIM_ALARM_COUNT];
+    int32_t next_alarm_id;
+    bool in_alarm;
+    bool async_ready[SIM_SPI_COUNT];
+    max6921_hal_spi_done_t async_done;
+    void *async_user_data;
+    uint8_t async_spi;
+} sim_state_t;
+
+static sim_state_t g_sim = {.chain_length = 1, .next_alarm_id = 1};
+
+/* Fire every alarm due by the current time, earliest first
+ * Callbacks run to completion, like an IRQ handler, and time they spend in
+ * the HAL advances the clock without firing alarms recursively.
+ */
+static void _dispatch_alarms(void) {
+    if (g_sim.in_alarm) {
+        return;
+    }
+
+    while (true) {
+        sim_alarm_t *next = NULL;
+        for (uint8_t i = 0; i < SIM_ALARM_COUNT; i++) {
+            sim_alarm_t *a = &g_sim.alarms[i];
+            if (a->active && a->due_us <= g_sim.now_us &&
+                (next == NULL || a->due_us < next->due_us)) {
+                next = a;
+            }
+        }
+        if (next == NULL) {
+            return;
+        }
+
+        g_sim.in_alarm = true;
+        int64_t ret = next->callback(next->id, next->user_data);
+        g_sim.in_alarm = false;
+
+        if (!next->active) {
+            continue;              /* Cancelled from inside the callback */
+        }
+        if (ret < 0) {
+            next->due_us += (uint64_t)(-ret);
+        } else if (ret > 0) {
+            next->due_us = g_sim.now_us + (uint64_t)ret;
+        } else {
+            next->active = false;
+        }
+    }
+}
+
+/* Move the clock forward, letting alarms interrupt at their due times */
+static void _advance(uint64_t us) {
+    uint64_t end = g_sim.now_us + us;
+
+    while (!g_sim.in_alarm) {
+        uint64_t due = end;
+        for (uint8_t i = 0; i < SIM_ALARM_COUNT; i++) {
+            if (g_sim.alarms[i].active && g_sim.alarms[i].due_us < due) {
+                due = g_sim.alarms[i].due_us;
+            }
+        }
+        if (due >= end) {
+            break;
+        }
+        if (due > g_sim.now_us) {
+            g_sim.now_us = due;
+        }
+        _dispatch_alarms();
+    }
+
+    if (end > g_sim.now_us) {
+        g_sim.now_us = end;
+    }
+    _dispatch_alarms();
+}
+
+/* Clock one bit into chip 0; each chip's bit 19 moves on to the next
+ * Returns the last chip's DOUT as the master would sample it with this
+ * edge: past the loopback's rate limit it still shows the previous bit.
+ */
+static uint32_t _shift_bit(uint32_t bit, uint32_t baud) {
+    for (uint8_t chip = 0; chip < g_sim.chain_length; chip++) {
+        uint32_t carry = (g_sim.shift[chip] >> 19) & 1u;
+        g_sim.shift[chip] = ((g_sim.shift[chip] << 1) | bit) & 0xFFFFFu;
+        bit = carry;
+    }
+
+    uint32_t sampled = (baud > g_sim.dout_max_baud) ? g_sim.dout : bit;
+    g_sim.dout = bit;
+    return sampled;
+}
+
+/* LOAD rising edge: copy the shift registers to the outputs and log it */
+static void _latch(void) {
+    memcpy(g_sim.outputs, g_sim.shift, sizeof(g_sim.outputs));
+
+    max6921_sim_latch_t *entry = &g_sim.log[g_sim.latches % MAX6921_SIM_LOG_SIZE];
+    entry->time_us = g_sim.now_us;
+    memcpy(entry->outputs, g_sim.outputs, sizeof(entry->outputs));
+    g_sim.latches++;
+}
+
+/* Simulator control */
+
+void max6921_sim_reset(uint8_t chain_length) {
+    memset(&g_sim, 0, sizeof(g_sim));
+    g_sim.chain_length = (chain_length >= 1 && chain_length <= VFD_CHAIN_MAX) ? chain_length : 1;
+    g_sim.next_alarm_id = 1;
+}
+
+uint64_t max6921_sim_time_us(void) {
+    return g_sim.now_us;
+}
+
+void max6921_sim_run_until(uint64_t time_us) {
+    if (time_us > g_sim.now_us) {
+        _advance(time_us - g_sim.now_us);
+    }
+}
+
+void max6921_sim_run_for(uint64_t us) {
+    _advance(us);
+}
+
+uint32_t max6921_sim_latch_count(void) {
+    return g_sim.latches;
+}
+
+const max6921_sim_latch_t *max6921_sim_latch(uint32_t index) {
+    if (index >= g_sim.latches || g_sim.latches - index > MAX6921_SIM_LOG_SIZE) {
+        return NULL;
+    }
+    return &g_sim.log[index % MAX6921_SIM_LOG_SIZE];
+}
+
+uint32_t max6921_sim_outputs(uint8_t chip) {
+    return (chip < VFD_CHAIN_MAX) ? g_sim.outputs[chip] : 0;
+}
+
+uint64_t max6921_sim_bits_shifted(void) {
+    return g_sim.bits;
+}
+
+uint64_t max6921_sim_bus_time_us(void) {
+    return g_sim.bus_time_us;
+}
+
+void max6921_sim_set_loopback(uint32_t max_baudrate) {
+    g_sim.dout_max_baud = max_baudrate;
+}
+
+/* HAL implementation */
+
+uint32_t max6921_hal_spi_init(uint8_t spi_index, uint32_t baudrate,
+                              uint8_t pin_tx, uint8_t pin_clk) {
+    (void)pin_tx;
+    (void)pin_clk;
+    if (spi_index >= SIM_SPI_COUNT || baudrate == 0) {
+        return 0;
+    }
+    g_sim.baudrate[spi_index] = baudrate;
+    g_sim.cs_latch[spi_index] = false;
+    return baudrate;
+}
+
+/* CSn wired to LOAD: every write ends in a latch edge, as on the chip */
+uint32_t max6921_hal_spi_init_latched(uint8_t spi_index, uint32_t baudrate,
+                                      uint8_t pin_tx, uint8_t pin_clk, uint8_t pin_cs) {
+    (void)pin_cs;
+    uint32_t actual = max6921_hal_spi_init(spi_index, baudrate, pin_tx, pin_clk);
+    if (actual != 0) {
+        g_sim.cs_latch[spi_index] = true;
+    }
+    return actual;
+}
+
+void max6921_hal_spi_deinit(uint8_t spi_index) {
+    if (spi_index < SIM_SPI_COUNT) {
+        g_sim.baudrate[spi_index] = 0;
+        g_sim.cs_latch[spi_index] = false;
+        g_sim.rx_routed[spi_index] = false;
+    }
+}
+
+uint32_t max6921_hal_spi_set_baudrate(uint8_t spi_index, uint32_t baudrate) {
+    if (spi_index >= SIM_SPI_COUNT || g_sim.baudrate[spi_index] == 0 || baudrate == 0) {
+        return 0;
+    }
+    g_sim.baudrate[spi_index] = baudrate;
+    return baudrate;
+}
+
+void max6921_hal_spi_init_rx(uint8_t spi_index, uint8_t pin_rx) {
+    (void)pin_rx;
+    if (spi_index < SIM_SPI_COUNT) {
+        g_sim.rx_routed[spi_index] = true;
+    }
+}
+
+/* Shift bytes into the chain, and DOUT into rx if given; returns the bus
+ * time, rounded up to whole us */
+static uint64_t _shift_bytes(uint8_t spi_index, const uint8_t *data, uint8_t *rx, size_t len) {
+    uint32_t baud = (spi_index < SIM_SPI_COUNT) ? g_sim.baudrate[spi_index] : 0;
+    if (baud == 0) {
+        return 0;
+    }
+
+    /* An unwired RX pin reads as zeros */
+    bool wired = g_sim.rx_routed[spi_index] && g_sim.dout_max_baud != 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t in = 0;
+        for (int bit = 7; bit >= 0; bit--) {
+            in = (uint8_t)((in << 1) | _shift_bit((data[i] >> bit) & 1u, baud));
+        }
+        if (rx != NULL) {
+            rx[i] = wired ? in : 0;
+        }
+    }
+
+    uint64_t bits = (uint64_t)len * 8;
+    uint64_t us = (bits * 1000000u + baud - 1) / baud;
+    g_sim.bits += bits;
+    g_sim.bus_time_us += us;
+    return us;
+}
+
+/* The "DMA complete" interrupt of a non-blocking write */
+static int64_t _async_complete(int32_t id, void *user_data) {
+    (void)id;
+    (void)user_data;
+    if (g_sim.cs_latch[g_sim.async_spi]) {
+        _latch();
+    }
+    g_sim.async_done(g_sim.async_user_data);
+    return 0;
+}
+
+void max6921_hal_spi_write(uint8_t spi_index, const uint8_t *data, size_t len) {
+    /* The call returns once the last bit is out */
+    _advance(_shift_bytes(spi_index, data, NULL, len));
+    if (spi_index < SIM_SPI_COUNT && g_sim.cs_latch[spi_index]) {
+        _latch();
+    }
+}
+
+void max6921_hal_spi_transfer(uint8_t spi_index, const uint8_t *tx, uint8_t *rx, size_t len) {
+    /* IRQs are off on the chip, so alarms wait until the end */
+    uint64_t us = _shift_bytes(spi_index, tx, rx, len);
+    bool in_alarm = g_sim.in_alarm;
+    g_sim.in_alarm = true;
+    _advance(us);
+    g_sim.in_alarm = in_alarm;
+    if (spi_index < SIM_SPI_COUNT && g_sim.cs_latch[spi_index]) {
+        _latch();
+    }
+    _dispatch_alarms();
+}
+
+bool max6921_hal_spi_async_init(uint8_t spi_index) {
+    if (spi_index >= SIM_SPI_COUNT) {
+        return false;
+    }
+    g_sim.async_ready[spi_index] = true;
+    return true;
+}
+
+void max6921_hal_spi_async_deinit(uint8_t spi_index) {
+    if (spi_index < SIM_SPI_COUNT) {
+        g_sim.async_ready[spi_index] = false;
+    }
+}
+
+/* Bits land in the chain at once; completion fires after the bus time */
+void max6921_hal_spi_write_async(uint8_t spi_index, const uint8_t *data, size_t len,
+                                 max6921_hal_spi_done_t done, void *user_data) {
+    if (spi_index >= SIM_SPI_COUNT || !g_sim.async_ready[spi_index]) {
+        return;
+    }
+    uint64_t us = _shift_bytes(spi_index, data, NULL, len);
+    g_sim.async_done = done;
+    g_sim.async_user_data = user_data;
+    g_sim.async_spi = spi_index;
+    max6921_hal_alarm_at(g_sim.now_us + us, _async_complete, NULL);
+}
+
+void max6921_hal_gpio_init_output(uint8_t pin) {
+    if (pin < 32) {
+        g_sim.pin_state[pin] = false;
+    }
+}
+
+void max6921_hal_gpio_put(uint8_t pin, bool value) {
+    if (pin >= 32) {
+        return;
+    }
+
+    /* LOAD is transparent while high; the rising edge is what we log */
+    if (value && !g_sim.pin_state[pin]) {
+        _latch();
+    }
+    g_sim.pin_state[pin] = value;
+}
+
+void max6921_hal_sleep_us(uint32_t us) {
+    _advance(us);
+}
+
+void max6921_hal_sleep_until(uint64_t time_us) {
+    max6921_sim_run_until(time_us);
+}
+
+void max6921_hal_busy_wait_us(uint32_t us) {
+    _advance(us);
+}
+
+uint64_t max6921_hal_time_us(void) {
+    return g_sim.now_us;
+}
+
+uint32_t max6921_hal_time_us_32(void) {
+    return (uint32_t)g_sim.now_us;
+}
+
+int32_t max6921_hal_alarm_at(uint64_t time_us, max6921_hal_alarm_callback_t callback,
+                             void *user_data) {
+    for (uint8_t i = 0; i < SIM_ALARM_COUNT; i++) {
+        sim_alarm_t *a = &g_sim.alarms[i];
+        if (!a->active) {
+            a->active = true;
+            a->id = g_sim.next_alarm_id++;
+            a->due_us = time_us;
+            a->callback = callback;
+            a->user_data = user_data;
+            return a->id;
+        }
+    }
+    return -1;
+}
+
+void max6921_hal_alarm_cancel(int32_t id) {
+    for (uint8_t i = 0; i < SIM_ALARM_COUNT; i++) {
+        if (g_sim.alarms[i].active && g_sim.alarms[i].id == id) {
+            g_sim.alarms[i].active = false;
+        }
+    }
+}
+
+bool max6921_sim_parse_trace(const char *line, vfd_trace_entry_t *entry) {
+    static const char *const kinds[] = {"word", "latch", "command"};
+    unsigned long time_us;
+    unsigned long value;
+    unsigned chip;
+    char kind[8];
+    if (sscanf(line, "trace,%lu,%7[a-z],%u,%lx", &time_us, kind, &chip, &value) != 4 ||
+        chip >= VFD_CHAIN_MAX) {
+        return false;
+    }
+
+    for (uint32_t k = 0; k < 3; k++) {
+        if (strcmp(kind, kinds[k]) == 0) {
+            entry->time_us = (uint32_t)time_us;
+            entry->data = (k << 30) | ((uint32_t)chip << 28) | ((uint32_t)value & 0xFFFFFu);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Font segments and command bits in one chip's outputs */
+static uint8_t _decode_segments(const vfd_output_map_t *map, uint32_t outputs) {
+    uint8_t segments = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        segments |= (uint8_t)(((outputs >> map->segment[i]) & 1u) << i);
+    }
+    return segments;
+}
+
+static uint8_t _decode_command(const vfd_output_map_t *map, uint32_t outputs) {
+    uint8_t command = 0;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (map->command[i] != VFD_OUTPUT_NONE && ((outputs >> map->command[i]) & 1u)) {
+            command |= (uint8_t)(1u << i);
+        }
+    }
+    return command;
+}
+
+uint32_t max6921_sim_decode_trace(const vfd_trace_entry_t *entries, uint32_t count,
+                                  const vfd_output_map_t *map, uint8_t grids,
+                                  uint8_t chain_length, max6921_sim_span_t *spans,
+                                  uint32_t max_spans) {
+    vfd_output_map_t default_map;
+    if (map == NULL) {
+        default_map = vfd_default_output_map(grids);
+        map = &default_map;
+    }
+    if (count == 0 || grids == 0 || grids > VFD_GRIDS_MAX || chain_length == 0 ||
+        chain_length > VFD_CHAIN_MAX) {
+        return 0;
+    }
+
+    uint32_t shifted[VFD_CHAIN_MAX] = {0};
+    int32_t open[VFD_GRIDS_MAX * VFD_CHAIN_MAX];
+    for (uint32_t i = 0; i < count_of(open); i++) {
+        open[i] = -1;
+    }
+    uint32_t written = 0;
+    uint32_t last = entries[0].time_us;
+    uint64_t now = last;
+
+    for (uint32_t e = 0; e < count; e++) {
+        now += (uint32_t)(entries[e].time_us - last);
+        last = entries[e].time_us;
+        uint32_t data = entries[e].data;
+        if (VFD_TRACE_KIND(data) == VFD_TRACE_WORD) {
+            if (VFD_TRACE_CHIP(data) < chain_length) {
+                shifted[VFD_TRACE_CHIP(data)] = VFD_TRACE_VALUE(data);
+            }
+            continue;
+        }
+        if (VFD_TRACE_KIND(data) != VFD_TRACE_LATCH) {
+            continue;
+        }
+
+        /* A grid showing the same as before keeps its span open */
+        for (uint8_t chip = 0; chip < chain_length; chip++) {
+            uint32_t outputs = shifted[chip];
+            uint8_t segments = _decode_segments(map, outputs);
+            uint8_t command = _decode_command(map, outputs);
+            for (uint8_t g = 0; g < grids; g++) {
+                uint8_t grid = (uint8_t)(grids * chip + g);
+                bool lit = (outputs >> map->grid[g]) & 1u;
+                int32_t s = open[grid];
+                if (s >= 0 && lit && spans[s].segments == segments &&
+                    spans[s].command == command) {
+                    continue;
+                }
+                if (s >= 0) {
+                    spans[s].end_us = now;
+                    open[grid] = -1;
+                }
+                if (lit && written < max_spans) {
+                    spans[written] = (max6921_sim_span_t){
+                        .start_us = now, .end_us = now, .grid = grid,
+                        .segments = segments, .command = command,
+                    };
+                    open[grid] = (int32_t)written++;
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < count_of(open); i++) {
+        if (open[i] >= 0) {
+            spans[open[i]].end_us = now;
+        }
+    }
+    return written;
+}
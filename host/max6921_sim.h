@@ -0,0 +1,111 @@
+/**
+ * @file max6921_sim.h
+ * @brief Host-side simulated MAX6921 chain behind the driver HAL
+ *
+ * Implements max6921_hal.h for MAX6921_HOST=1 builds. SPI writes shift bits
+ * into a model of the cascaded 20-bit shift registers, a rising edge on the
+ * latch pin (or the end of a write, when CSn drives LOAD) copies them to
+ * the outputs and is logged, and all delays run on
+ * a virtual clock that advances by the time the bus would really take. The
+ * driver's timer engine runs on the same clock: pending alarms fire as
+ * virtual time passes, as if from an interrupt.
+ */
+
+#ifndef MAX6921_SIM_H
+#define MAX6921_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "max6921.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Latch events kept in the log (oldest are overwritten) */
+#define MAX6921_SIM_LOG_SIZE 4096
+
+/* One latch edge: outputs of every chip, chip 0 nearest the MCU */
+typedef struct {
+    uint64_t time_us;
+    uint32_t outputs[VFD_CHAIN_MAX];
+} max6921_sim_latch_t;
+
+/**
+ * Reset clock, bus and log, and model chain_length cascaded chips
+ */
+void max6921_sim_reset(uint8_t chain_length);
+
+/**
+ * Virtual time since reset
+ */
+uint64_t max6921_sim_time_us(void);
+
+/**
+ * Advance virtual time, firing due alarms in order
+ */
+void max6921_sim_run_until(uint64_t time_us);
+void max6921_sim_run_for(uint64_t us);
+
+/**
+ * Latch edges since reset, and the i-th one (NULL once overwritten)
+ */
+uint32_t max6921_sim_latch_count(void);
+const max6921_sim_latch_t *max6921_sim_latch(uint32_t index);
+
+/**
+ * Current latched outputs of one chip (20 bits)
+ */
+uint32_t max6921_sim_outputs(uint8_t chip);
+
+/**
+ * Bus statistics since reset: bits shifted and time spent shifting them
+ */
+uint64_t max6921_sim_bits_shifted(void);
+uint64_t max6921_sim_bus_time_us(void);
+
+/**
+ * Wire the last chip's DOUT back to the SPI RX pin
+ * Up to max_baudrate it reads back cleanly; faster, each sample still
+ * sees the previous bit, as a slow DOUT edge would. 0 unwires it.
+ */
+void max6921_sim_set_loopback(uint32_t max_baudrate);
+
+/* Trace decoding
+ * Replays a driver trace (vfd_get_trace() entries, or vfd_dump_trace()
+ * lines read back with max6921_sim_parse_trace()) through the same model
+ * of the chain, and turns every latch into what each grid showed until
+ * the next one. Grids that are on together, as with ghosting, each get a
+ * span of their own.
+ */
+
+/* One grid showing one pattern from start_us to end_us */
+typedef struct {
+    uint64_t start_us;             /* Unwrapped from the trace's 32-bit stamps */
+    uint64_t end_us;
+    uint8_t grid;                  /* grids * chip + grid, as vfd_write_segments() counts */
+    uint8_t segments;              /* Font segments, through the output map */
+    uint8_t command;               /* Command bits held meanwhile */
+} max6921_sim_span_t;
+
+/**
+ * Read one "trace,..." line of a dump; false for anything else, "trace,end" included
+ */
+bool max6921_sim_parse_trace(const char *line, vfd_trace_entry_t *entry);
+
+/**
+ * Decode count entries into at most max_spans spans, in the order they
+ * started; returns how many were written
+ * map and grids describe the board as its config did (NULL: the default
+ * wiring). Spans still open at the end close at the last entry.
+ */
+uint32_t max6921_sim_decode_trace(const vfd_trace_entry_t *entries, uint32_t count,
+                                  const vfd_output_map_t *map, uint8_t grids,
+                                  uint8_t chain_length, max6921_sim_span_t *spans,
+                                  uint32_t max_spans);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAX6921_SIM_H */
@@ -0,0 +1,58 @@
+/**
+ * @file trace_decode.c
+ * @brief Turn a vfd_dump_trace() capture back into what each grid showed
+ *
+ * Build (from the repository root) and feed it a dump, e.g. a serial log:
+ *
+ *   cc -O2 -std=c11 -DMAX6921_HOST=1 -I. -Ihost \
+ *      max6921.c host/max6921_sim.c host/trace_decode.c -o trace_decode
+ *   ./trace_decode [grids [chain_length]] < capture.txt
+ *
+ * Lines other than "trace,..." are skipped, so the log need not be
+ * trimmed. grids and chain_length are the board's config (default 9 and
+ * 1, default wiring). Prints one CSV line per span, in the order they
+ * started:
+ *
+ *   span,<grid>,<start_us>,<duration_us>,<segments_hex>,<command>,<segment names>
+ *
+ * Two grids whose spans overlap were lit at the same time.
+ */
+
+#include "max6921.h"
+#include "max6921_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_DECODE_MAX 65536
+
+static vfd_trace_entry_t entries[TRACE_DECODE_MAX];
+static max6921_sim_span_t spans[TRACE_DECODE_MAX];
+
+int main(int argc, char **argv) {
+    uint8_t grids = (argc > 1) ? (uint8_t)atoi(argv[1]) : 9;
+    uint8_t chain_length = (argc > 2) ? (uint8_t)atoi(argv[2]) : 1;
+
+    uint32_t count = 0;
+    char line[128];
+    while (count < TRACE_DECODE_MAX && fgets(line, sizeof(line), stdin) != NULL) {
+        if (max6921_sim_parse_trace(line, &entries[count])) {
+            count++;
+        }
+    }
+
+    uint32_t written = max6921_sim_decode_trace(entries, count, NULL, grids, chain_length, spans,
+                                                TRACE_DECODE_MAX);
+    for (uint32_t i = 0; i < written; i++) {
+        const max6921_sim_span_t *s = &spans[i];
+        char names[32];
+        vfd_segments_to_string(s->segments, names, sizeof(names));
+        printf("span,%u,%llu,%llu,%02x,%u,%s\n", s->grid, (unsigned long long)s->start_us,
+               (unsigned long long)(s->end_us - s->start_us), s->segments, s->command, names);
+    }
+
+    if (count == 0) {
+        fprintf(stderr, "no trace lines on stdin\n");
+        return 1;
+    }
+    return 0;
+}
@@ -4,32 +4,24 @@
  */
 
 #include "max6921.h"
+#include "max6921_hal.h"
+#include "max6921_font.h"
 #include <stdio.h>
 #include <string.h>
+#if !MAX6921_HOST
 #include "pico/stdlib.h"
-#include "hardware/spi.h"
-
-/* Internal driver state */
-typedef struct {
-    bool initialized;
-    vfd_config_t config;
-    vfd_display_buffer_t display_buffer;
-    spi_inst_t *spi_port;
-    uint8_t spi_data[3];
-} vfd_driver_state_t;
-
-/* Grid control patterns (one grid active at a time) */
-static const uint16_t GRID_PATTERNS[9] = {
-    0b100000000,  /* Grid 0 */
-    0b010000000,  /* Grid 1 */
-    0b001000000,  /* Grid 2 */
-    0b000100000,  /* Grid 3 */
-    0b000010000,  /* Grid 4 */
-    0b000001000,  /* Grid 5 */
-    0b000000100,  /* Grid 6 */
-    0b000000010,  /* Grid 7 */
-    0b000000001   /* Grid 8 */
-};
+#include "pico/multicore.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "hardware/rtc.h"
+#include "hardware/irq.h"
+#endif
+
+/* Core 1 FIFO messages: [type(8) | argument(24)] */
+#define VFD_CORE1_MSG_COMMAND 0x01000000u
+#define VFD_CORE1_MSG_STOP    0x02000000u
+#define VFD_CORE1_MSG_TYPE    0xFF000000u
 
 /* Digit to segment mapping */
 static const uint8_t DIGIT_PATTERNS[13] = {
@@ -48,16 +40,93 @@ static const uint8_t DIGIT_PATTERNS[13] = {
     VFD_BLANK
 };
 
-static vfd_driver_state_t g_vfd_state = {
-    .initialized = false,
-    .config = {0},
-    .display_buffer = {0},
-    .spi_port = spi1
+/* ASCII / Latin-1 to segment font, one byte per character code */
+#define VFD_FONT_ENTRY(code, segments) [(uint8_t)(code)] = (uint8_t)(segments),
+static const uint8_t ASCII_FONT[256] = {
+    MAX6921_FONT(VFD_FONT_ENTRY)
+};
+#undef VFD_FONT_ENTRY
+
+/* Longest hold of one PIO word (12-bit count) */
+#define MAX6921_PIO_HOLD_MAX 0x1000
+
+#if !MAX6921_HOST
+/* PIO scan-out program
+ * Each 32-bit FIFO word is [20-bit control word | 12-bit hold count].
+ * Shifts the 20 data bits MSB first on the out pin with SCK on side-set,
+ * pulses LOAD on the set pin, then holds the grid for 8 * (hold + 1) cycles.
+ * The state machine runs at twice the configured SPI baud rate.
+ *
+ *     .program max6921
+ *     .side_set 1 opt
+ *     .wrap_target
+ *         pull block          side 0
+ *         set x, 19
+ *     bitloop:
+ *         out pins, 1         side 0
+ *         jmp x-- bitloop     side 1
+ *         set pins, 1         side 0
+ *         out x, 12
+ *         set pins, 0
+ *     hold:
+ *         jmp x-- hold        [7]
+ *     .wrap
+ */
+static const uint16_t MAX6921_PIO_INSTRUCTIONS[] = {
+    0x90A0,  /* 0: pull block          side 0 */
+    0xE033,  /* 1: set x, 19 */
+    0x7001,  /* 2: out pins, 1         side 0 */
+    0x1842,  /* 3: jmp x-- 2           side 1 */
+    0xF001,  /* 4: set pins, 1         side 0 */
+    0x602C,  /* 5: out x, 12 */
+    0xE000,  /* 6: set pins, 0 */
+    0x0747   /* 7: jmp x-- 7           [7] */
+};
+
+static const pio_program_t MAX6921_PIO_PROGRAM = {
+    .instructions = MAX6921_PIO_INSTRUCTIONS,
+    .length = 8,
+    .origin = -1
 };
 
-/* Validate grid index */
-static bool _is_valid_grid(uint8_t grid) {
-    return grid < 9;
+#define MAX6921_PIO_WRAP_TARGET 0
+#define MAX6921_PIO_WRAP 7
+#define MAX6921_PIO_CYCLES_PER_HOLD 8
+#define MAX6921_PIO_SHIFT_CYCLES 45
+#endif
+
+/* Instance behind the original single-display API */
+static vfd_t g_vfd_default;
+
+/* Instance that currently owns core 1, if any */
+static vfd_t *g_vfd_core1_owner;
+
+#if !MAX6921_HOST
+/* Instance whose clock runs from the RTC alarm or a PPS pin, if any */
+static vfd_t *g_vfd_clock_owner;
+#endif
+
+/* Free-running uint16_t ring indices need a size that divides 65536 */
+#if VFD_UPDATE_QUEUE_SIZE < 1 || VFD_UPDATE_QUEUE_SIZE > 32768 || \
+    (VFD_UPDATE_QUEUE_SIZE & (VFD_UPDATE_QUEUE_SIZE - 1)) != 0
+#error "VFD_UPDATE_QUEUE_SIZE must be a power of two"
+#endif
+
+#if !MAX6921_HOST
+/* PIO block selected by the instance's config */
+static inline PIO _pio_block(const vfd_t *vfd) {
+    return (vfd->config.pio_index == 0) ? pio0 : pio1;
+}
+#endif
+
+/* Validate grid index (0..grids * chain_length - 1) */
+static bool _is_valid_grid(const vfd_t *vfd, uint8_t grid) {
+    return grid < vfd->grid_count;
+}
+
+/* Validate a non-empty window of grids [first, first + count) */
+static bool _is_valid_range(const vfd_t *vfd, uint8_t first, uint8_t count) {
+    return count > 0 && first < vfd->grid_count && count <= vfd->grid_count - first;
 }
 
 /* Validate segment pattern */
@@ -66,291 +135,3902 @@ static bool _is_valid_segment(uint8_t segment) {
     return true;
 }
 
-/* Write raw data to VFD chip
- * Constructs the 20-bit control word: [COMMAND(3) | GRID(9) | SEGMENTS(8)]
- * Command bits (19-17) default to 0 for display-only operation
- *
- * The MAX6921 is a 20-bit shift register. Since SPI operates on whole bytes,
- * we transmit 3 bytes (24 bits) total: 4 padding bits + 20-bit control word.
- * The padding bits are transmitted first (MSB-first), shifting the 20-bit word
- * into the correct position in the shift register.
- *
- * Format: [4-bit padding | COMMAND(3) | GRID(9) | SEGMENTS(8)]
- */
-static void _write_vfd_raw(uint8_t grid, uint8_t segments) {
-    if (!_is_valid_grid(grid)) {
-        return;
+/* Validate command bits (0-7, and only bits the output map wires) */
+static bool _is_valid_command(const vfd_t *vfd, uint8_t command) {
+    return (command & ~vfd->command_mask) == 0;
+}
+
+/* Take output bit for one signal; false if it is out of range or taken */
+static bool _claim_output(uint32_t *used, uint8_t bit) {
+    if (bit >= 20 || (*used & (1u << bit))) {
+        return false;
     }
+    *used |= 1u << bit;
+    return true;
+}
 
-    uint32_t combined_data = ((uint32_t)GRID_PATTERNS[grid] << 8) | segments;
+/* Check an output map and turn it into the tables encoding reads
+ * Done once at init, so a board wired in any order encodes each grid with
+ * the same few lookups as the default wiring: one for the grid, one per
+ * segment nibble and one for the command bits.
+ */
+static bool _build_output_map(vfd_t *vfd, const vfd_output_map_t *map) {
+    uint32_t used = 0;
+    for (uint8_t step = 0; step < vfd->steps; step++) {
+        if (!_claim_output(&used, map->grid[step])) {
+            return false;
+        }
+        vfd->grid_bits[step] = 1u << map->grid[step];
+    }
+    for (uint8_t segment = 0; segment < 8; segment++) {
+        if (!_claim_output(&used, map->segment[segment])) {
+            return false;
+        }
+    }
 
-    g_vfd_state.spi_data[0] = (combined_data >> 16) & 0xFF;
-    g_vfd_state.spi_data[1] = (combined_data >> 8) & 0xFF;
-    g_vfd_state.spi_data[2] = combined_data & 0xFF;
+    vfd->command_mask = 0;
+    for (uint8_t bit = 0; bit < 3; bit++) {
+        if (map->command[bit] == VFD_OUTPUT_NONE) {
+            continue;
+        }
+        if (!_claim_output(&used, map->command[bit])) {
+            return false;
+        }
+        vfd->command_mask |= (uint8_t)(1u << bit);
+    }
 
-    spi_write_blocking(g_vfd_state.spi_port, g_vfd_state.spi_data, 3);
+    for (uint8_t nibble = 0; nibble < 16; nibble++) {
+        uint32_t low = 0;
+        uint32_t high = 0;
+        for (uint8_t i = 0; i < 4; i++) {
+            if (nibble & (1u << i)) {
+                low |= 1u << map->segment[i];
+                high |= 1u << map->segment[i + 4];
+            }
+        }
+        vfd->segment_bits[0][nibble] = low;
+        vfd->segment_bits[1][nibble] = high;
+    }
+    for (uint8_t command = 0; command < 8; command++) {
+        uint32_t word = 0;
+        for (uint8_t bit = 0; bit < 3; bit++) {
+            if (command & vfd->command_mask & (1u << bit)) {
+                word |= 1u << map->command[bit];
+            }
+        }
+        vfd->command_bits[command] = word;
+    }
+    return true;
+}
 
-    gpio_put(g_vfd_state.config.pin_latch, 1);
-    sleep_us(1);
-    gpio_put(g_vfd_state.config.pin_latch, 0);
+/* Pack a 20-bit control word into a PIO FIFO word
+ * [20-bit control word | 12-bit hold count], holding the word on the outputs
+ * for hold_units (1..4096) hold periods.
+ */
+static uint32_t _pack_word(uint32_t control_word, uint32_t hold_units) {
+    return (control_word << 12) | (hold_units - 1);
 }
 
-/* Initialize GPIO pins */
-static vfd_error_t _init_gpio(const vfd_config_t *config) {
-    uint actual_baudrate = spi_init(g_vfd_state.spi_port, config->spi_baudrate);
-    
-    if (actual_baudrate == 0) {
-        return VFD_ERR_HARDWARE;
+/* Pack one control word per chip into a single SPI burst
+ * The MAX6921 is a 20-bit shift register, and cascaded chips form one long
+ * register through DOUT -> DIN. The words are packed back to back, the
+ * farthest chip's first, into burst_bytes (N * 20 bits rounded up to whole
+ * bytes, or whole 16-bit frames with VFD_LATCH_SPI_CS). Padding bits are
+ * transmitted first (MSB-first) and fall off the end of the chain, so one
+ * LOAD pulse latches every chip at once.
+ *
+ * One chip: [4-bit padding | 20 outputs], bit n driving OUTn
+ */
+static void _pack_burst(const vfd_t *vfd, uint8_t *out, const uint32_t *control_words) {
+    uint8_t chain = vfd->config.chain_length;
+    uint32_t acc = 0;
+    uint32_t bits = vfd->burst_bytes * 8u - chain * 20u;
+
+    for (uint8_t chip = chain; chip-- > 0;) {
+        acc = (acc << 20) | control_words[chip];
+        bits += 20;
+        while (bits >= 8) {
+            bits -= 8;
+            *out++ = (uint8_t)(acc >> bits);
+        }
     }
+}
 
-    gpio_set_function(config->pin_spi_clk, GPIO_FUNC_SPI);
-    gpio_set_function(config->pin_spi_tx, GPIO_FUNC_SPI);
-
-    gpio_init(config->pin_latch);
-    gpio_set_dir(config->pin_latch, GPIO_OUT);
-    gpio_put(config->pin_latch, 0);
+/* Part index of total split into parts whole-us shares, remainder first */
+static uint32_t _share(uint32_t total, uint32_t parts, uint32_t index) {
+    return total / parts + ((index < total % parts) ? 1 : 0);
+}
 
-    return VFD_OK;
+/* Output bits of one chip's segment pattern, through the output map */
+static inline uint32_t _segment_word(const vfd_t *vfd, uint8_t segments) {
+    return vfd->segment_bits[0][segments & 0x0F] | vfd->segment_bits[1][segments >> 4];
 }
 
-/* Public API */
+/* Time one step of a frame
+ * The slot is split PWM-style: the lit word holds for level/15 of duty/steps of
+ * it and the blank word for the rest, so dimming never changes the frame
+ * rate. Timed engines use slot_us and on_us; the PIO words carry their own
+ * hold counts, of units in total.
+ */
+static void _time_grid(vfd_t *vfd, vfd_frame_t *frame, uint8_t grid, uint32_t slot_us,
+                       uint32_t units, uint32_t duty) {
+    uint32_t level = frame->levels[grid];
+    frame->slot_us[grid] = slot_us;
+    frame->on_us[grid] = (slot_us * level * duty) / (VFD_BRIGHTNESS_MAX * vfd->steps);
 
-vfd_config_t vfd_default_config(void) {
-    vfd_config_t config = {
-        .spi_baudrate = 2000000,
-        .pin_spi_tx = 11,
-        .pin_spi_clk = 10,
-        .pin_latch = 13,
-        .refresh_interval_us = 1500
-    };
-    return config;
+    if (vfd->config.backend != VFD_BACKEND_PIO) {
+        return;
+    }
+
+    /* Both words hold for at least one unit; a full level loses only that */
+    uint32_t on_units = (units * level * duty) / (VFD_BRIGHTNESS_MAX * vfd->steps);
+    if (on_units < 1) {
+        on_units = 1;
+    } else if (on_units > units - 1) {
+        on_units = units - 1;
+    }
+    uint32_t off_units = units - on_units;
+
+    /* _init_pio() only accepts slots whose units, stretched over every
+     * step, still fit the hold count, so both words hold what slot_us says */
+    frame->words[2 * grid] = _pack_word(frame->words[2 * grid] >> 12, on_units);
+    frame->words[2 * grid + 1] = _pack_word(vfd->command_bits[frame->commands[0][grid]], off_units);
 }
 
-vfd_error_t vfd_init(const vfd_config_t *config) {
-    if (g_vfd_state.initialized) {
-        return VFD_OK;
+/* Encode one grid of a frame into its cached words
+ * The 20-bit control word is the step's grid output, the segment outputs
+ * and the command outputs, all taken from the tables the output map was
+ * turned into at init. Command bits come from the grid's command and go
+ * into the blank word too, so they hold steady through the whole slot
+ * In VFD_SCAN_FULL the grid is timed here; the adaptive modes time the
+ * whole frame in _schedule_frame() once encoding is done.
+ */
+static void _encode_grid(vfd_t *vfd, vfd_frame_t *frame, uint8_t grid) {
+    uint8_t level = frame->levels[grid];
+    uint32_t combined_data[VFD_CHAIN_MAX] = {0};
+    uint32_t blank[VFD_CHAIN_MAX] = {0};
+    for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+        blank[chip] = vfd->command_bits[frame->commands[chip][grid]];
+        combined_data[chip] = blank[chip];
+        if (level > 0) {
+            combined_data[chip] |= vfd->grid_bits[grid] |
+                                   _segment_word(vfd, frame->segments[chip][grid]);
+        }
     }
 
-    if (config == NULL) {
-        g_vfd_state.config = vfd_default_config();
+    if (vfd->config.backend != VFD_BACKEND_PIO) {
+        _pack_burst(vfd, frame->bursts[2 * grid], combined_data);
+        _pack_burst(vfd, frame->bursts[2 * grid + 1], blank);
     } else {
-        if (config->spi_baudrate == 0 || config->refresh_interval_us == 0) {
-            return VFD_ERR_INVALID_PARAM;
+        frame->words[2 * grid] = _pack_word(combined_data[0], 1);
+    }
+
+    if (vfd->config.scan_mode == VFD_SCAN_FULL) {
+        _time_grid(vfd, frame, grid, _share(vfd->frame_us, vfd->steps, grid),
+                   vfd->pio_hold_units, vfd->steps);
+    }
+}
+
+/* Decide which steps a frame scans and, in the adaptive modes, time them
+ * A step is skipped when its grid is blank on every chip or at level 0,
+ * and holds no command bits.
+ * With n of s steps left, SHORTEN keeps the slot length (frame rate up by
+ * s/n, lit grids brighter by the same factor), SHORTEN_CONSTANT also cuts
+ * the lit part to n/s so brightness does not depend on content, and STRETCH
+ * keeps the frame length by giving each step s/n slots. On the PIO backend
+ * skipped steps still go through the FIFO, with the shortest holds.
+ */
+static void _schedule_frame(vfd_t *vfd, vfd_frame_t *frame) {
+    vfd_scan_mode_t mode = vfd->config.scan_mode;
+    uint16_t mask = 0;
+    uint32_t lit = 0;
+    for (uint8_t grid = 0; grid < vfd->steps; grid++) {
+        for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+            if (frame->commands[chip][grid] != 0 ||
+                (frame->levels[grid] > 0 && frame->segments[chip][grid] != VFD_BLANK)) {
+                mask |= (uint16_t)(1u << grid);
+                lit++;
+                break;
+            }
         }
-        g_vfd_state.config = *config;
     }
 
-    stdio_init_all();
+    frame->lit_mask = mask;
+    if (mode == VFD_SCAN_FULL) {
+        frame->scan_mask = vfd->all_steps;
+        frame->period_us = vfd->frame_us;
+        return;
+    }
 
-    vfd_error_t err = _init_gpio(&g_vfd_state.config);
-    if (err != VFD_OK) {
-        return err;
+    /* An all-blank frame still scans one dark step to keep the engine ticking */
+    if (mask == 0) {
+        mask = 1;
+        lit = 1;
     }
 
-    vfd_clear();
+    uint32_t units = vfd->pio_hold_units;
+    uint32_t duty = vfd->steps;
+    if (mode == VFD_SCAN_STRETCH) {
+        units = (units * vfd->steps) / lit;
+    } else if (mode == VFD_SCAN_SHORTEN_CONSTANT) {
+        duty = lit;
+    }
 
-    g_vfd_state.initialized = true;
-    return VFD_OK;
+    /* STRETCH splits the whole frame between the scanned steps */
+    uint32_t index = 0;
+    uint32_t period_us = 0;
+    for (uint8_t grid = 0; grid < vfd->steps; grid++) {
+        uint32_t slot_us = vfd->config.refresh_interval_us;
+        if (mode == VFD_SCAN_STRETCH) {
+            slot_us = _share(vfd->frame_us, lit, (mask & (1u << grid)) ? index : lit);
+        }
+        if (mask & (1u << grid)) {
+            _time_grid(vfd, frame, grid, slot_us, units, duty);
+            period_us += frame->slot_us[grid];
+            index++;
+        } else {
+            _time_grid(vfd, frame, grid, slot_us, 2, duty);
+        }
+    }
+    frame->scan_mask = mask;
+    frame->period_us = period_us;
 }
 
-bool vfd_is_initialized(void) {
-    return g_vfd_state.initialized;
+/* Next step at or after grid that the scan visits, steps past the last
+ * A marquee window or clock face is always visited, whatever is committed
+ * under it.
+ */
+static uint8_t _next_step(const vfd_t *vfd, const vfd_frame_t *frame, uint8_t grid) {
+    uint16_t mask = frame->scan_mask | vfd->marquee.scan_mask | vfd->clock.scan_mask |
+                    vfd->posted.scan_mask;
+    while (grid < vfd->steps && !(mask & (1u << grid))) {
+        grid++;
+    }
+    return grid;
 }
 
-vfd_error_t vfd_deinit(void) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* First step of a frame; every scheduled frame visits at least one */
+static uint8_t _first_step(const vfd_t *vfd, const vfd_frame_t *frame) {
+    uint8_t grid = _next_step(vfd, frame, 0);
+    return (grid < vfd->steps) ? grid : 0;
+}
+
+/* Store a grid pattern in the back buffer and mark it for the next commit
+ * Dirty and stale masks track scan steps, which cover grid % steps of every chip.
+ * Rewriting the pattern a grid already has leaves it clean, so redrawing a
+ * whole line only re-encodes the grids that really changed.
+ */
+static inline void _set_grid(vfd_t *vfd, uint8_t grid, uint8_t segments) {
+    uint8_t step = vfd->grid_slot[grid] & 0x0F;
+    uint8_t *slot = &vfd->frames[vfd->back].segments[vfd->grid_slot[grid] >> 4][step];
+    if (*slot != segments) {
+        *slot = segments;
+        vfd->dirty |= (uint16_t)(1u << step);
     }
+}
 
-    vfd_clear();
-    vfd_refresh();
+/* Blank every grid of the back buffer */
+static void _clear(vfd_t *vfd) {
+    for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+        _set_grid(vfd, grid, VFD_BLANK);
+    }
+}
 
-    spi_deinit(g_vfd_state.spi_port);
+/* Store a grid's command bits in the back buffer, dirty only if changed */
+static void _set_command(vfd_t *vfd, uint8_t grid, uint8_t command) {
+    uint8_t step = vfd->grid_slot[grid] & 0x0F;
+    uint8_t *slot = &vfd->frames[vfd->back].commands[vfd->grid_slot[grid] >> 4][step];
+    if (*slot != command) {
+        *slot = command;
+        vfd->dirty |= (uint16_t)(1u << step);
+    }
+}
 
-    g_vfd_state.initialized = false;
-    return VFD_OK;
+/* Segment pattern of a grid in the back buffer */
+static uint8_t _get_grid(const vfd_t *vfd, uint8_t grid) {
+    uint8_t slot = vfd->grid_slot[grid];
+    return vfd->frames[vfd->back].segments[slot >> 4][slot & 0x0F];
 }
 
-vfd_error_t vfd_write_segments(uint8_t grid, uint8_t segments) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Render text into grids [first, first + width) of the back buffer
+ * One font lookup per character, stored straight into the buffer. A '.'
+ * following a character lights that grid's decimal point instead of
+ * taking a grid of its own. Grids the text does not reach are blanked.
+ */
+static void _render_text(vfd_t *vfd, uint8_t first, uint8_t width, const char *str) {
+    uint8_t end = first + width;
+    uint8_t grid = first;
+    bool can_fold = false;
+
+    for (const char *p = str; *p != '\0'; p++) {
+        uint8_t c = (uint8_t)*p;
+        if (c == '.' && can_fold) {
+            _set_grid(vfd, grid - 1, _get_grid(vfd, grid - 1) | VFD_SYMBOL_DOT);
+            can_fold = false;
+            continue;
+        }
+        if (grid >= end) {
+            break;
+        }
+        _set_grid(vfd, grid, ASCII_FONT[c]);
+        can_fold = (c != '.');
+        grid++;
     }
 
-    if (!_is_valid_grid(grid)) {
-        return VFD_ERR_INVALID_GRID;
+    for (; grid < end; grid++) {
+        _set_grid(vfd, grid, VFD_BLANK);
     }
+}
 
-    if (!_is_valid_segment(segments)) {
-        return VFD_ERR_INVALID_SEGMENT;
-    }
+/* Move front to the latest commit (engine side, at a frame boundary)
+ * The latching flag brackets the read of ready and the write of front, so
+ * the other core can tell when front is about to change under it. The
+ * animation player's stage is picked up the same way.
+ */
+static void _latch_front(vfd_t *vfd) {
+    vfd->latching = true;
+    __dmb();
+    vfd->front = vfd->ready;
+    vfd->player.scan_stage = vfd->player.ready_stage;
+    __dmb();
+    vfd->latching = false;
+}
 
-    g_vfd_state.display_buffer[grid] = segments;
-    return VFD_OK;
+/* Frame a CPU scanner sends from: an animation stage or the front frame */
+static inline const vfd_frame_t *_scan_source(const vfd_t *vfd) {
+    int8_t stage = vfd->player.scan_stage;
+    return (stage >= 0) ? &vfd->player.stage[stage] : &vfd->frames[vfd->front];
 }
 
-vfd_error_t vfd_read_segments(uint8_t grid, uint8_t *segments) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Wait until no CPU scanner is inside _latch_front() */
+static void _wait_latch(vfd_t *vfd) {
+    __dmb();
+    while (vfd->latching) {
+        tight_loop_contents();
     }
+}
 
-    if (!_is_valid_grid(grid)) {
-        return VFD_ERR_INVALID_GRID;
+#if !MAX6921_HOST
+/* Words the DMA engine should stream from its next frame on */
+static const uint32_t *_dma_source(const vfd_t *vfd) {
+    int8_t stage = vfd->player.ready_stage;
+    return (stage >= 0) ? vfd->player.stage[stage].words : vfd->frames[vfd->ready].words;
+}
+
+/* Read address of the DMA data channel, skipping the few cycles in which
+ * the control channel is re-arming it */
+static uintptr_t _dma_read_addr(vfd_t *vfd) {
+    uint data_chan = (uint)vfd->dma_data_chan;
+    uint ctrl_chan = (uint)vfd->dma_ctrl_chan;
+    while (dma_channel_is_busy(ctrl_chan) || !dma_channel_is_busy(data_chan)) {
+        tight_loop_contents();
     }
+    return (uintptr_t)dma_hw->ch[data_chan].read_addr;
+}
 
-    if (segments == NULL) {
-        return VFD_ERR_INVALID_PARAM;
+static bool _dma_reads(uintptr_t addr, const vfd_frame_t *frame) {
+    uintptr_t base = (uintptr_t)frame->words;
+    return addr >= base && addr <= base + sizeof(frame->words);
+}
+#endif
+
+/* Index of the frame the scan engine is currently reading
+ * Called after ready was updated, so front can only still move to ready.
+ * The timer ISR latches atomically with respect to the caller; core 1 may be
+ * inside _latch_front() and is waited out, which takes a few cycles. DMA has
+ * no such variable, so the data channel's read address is decoded instead.
+ */
+static uint8_t _scanning_frame(vfd_t *vfd) {
+    if (vfd->engine != VFD_ENGINE_DMA) {
+        _wait_latch(vfd);
+        return vfd->front;
     }
 
-    *segments = g_vfd_state.display_buffer[grid];
-    return VFD_OK;
+#if !MAX6921_HOST
+    uintptr_t addr = _dma_read_addr(vfd);
+    for (uint8_t i = 0; i < VFD_FRAME_COUNT; i++) {
+        if (_dma_reads(addr, &vfd->frames[i])) {
+            return i;
+        }
+    }
+#endif
+    return vfd->ready;
 }
 
-vfd_error_t vfd_write_digit(uint8_t grid, uint8_t digit) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Hand a committed frame to whoever scans it
+ * Without a running engine or non-blocking refresh the flip takes effect
+ * immediately. While an animation plays, DMA stays on its stages until the
+ * player lets go.
+ */
+static void _publish_frame(vfd_t *vfd, uint8_t index) {
+    vfd->ready = index;
+    vfd->commit_seq++;
+    __dmb();
+
+    if (vfd->engine == VFD_ENGINE_NONE && !vfd->async_busy) {
+        vfd->front = index;
+    } else if (vfd->engine == VFD_ENGINE_DMA && !vfd->player.active) {
+        vfd->dma_frame_addr = vfd->frames[index].words;
     }
+}
 
-    if (!_is_valid_grid(grid)) {
-        return VFD_ERR_INVALID_GRID;
+/* Pick the next back buffer and bring it up to date
+ * Only grids committed since this frame was last written are copied over.
+ */
+static void _rotate_back(vfd_t *vfd) {
+    uint8_t ready = vfd->ready;
+    uint8_t scanning = _scanning_frame(vfd);
+
+    uint8_t back = 0;
+    while (back == ready || back == scanning) {
+        back++;
     }
 
-    if (digit > 9) {
-        return VFD_ERR_INVALID_PARAM;
+    vfd_frame_t *dst = &vfd->frames[back];
+    const vfd_frame_t *src = &vfd->frames[ready];
+    uint16_t mask = vfd->stale[back];
+    for (uint8_t grid = 0; mask != 0; grid++, mask >>= 1) {
+        if (mask & 1) {
+            for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+                dst->segments[chip][grid] = src->segments[chip][grid];
+                dst->commands[chip][grid] = src->commands[chip][grid];
+            }
+            dst->levels[grid] = src->levels[grid];
+            dst->slot_us[grid] = src->slot_us[grid];
+            dst->on_us[grid] = src->on_us[grid];
+            if (vfd->config.backend == VFD_BACKEND_PIO) {
+                dst->words[2 * grid] = src->words[2 * grid];
+                dst->words[2 * grid + 1] = src->words[2 * grid + 1];
+            } else {
+                memcpy(dst->bursts[2 * grid], src->bursts[2 * grid], 2 * sizeof(dst->bursts[0]));
+            }
+        }
     }
 
-    g_vfd_state.display_buffer[grid] = DIGIT_PATTERNS[digit];
-    return VFD_OK;
+    vfd->stale[back] = 0;
+    vfd->back = back;
 }
 
-vfd_error_t vfd_clear(void) {
-    memset(g_vfd_state.display_buffer, VFD_BLANK, sizeof(vfd_display_buffer_t));
-    return VFD_OK;
+/* Posted updates
+ * Records posted from interrupts go through a single-consumer ring. While a
+ * scan runs that consumer is the scanner, at each frame boundary, into the
+ * posted state it sends over the frame (_posted_frame()); a commit holds
+ * the scanner off, folds that state into the back buffer and drains the
+ * rest itself. The producer fills a record before publishing it through
+ * head, and a record is only handed back through tail once it has been
+ * read. Indices run freely; the ring size divides 65536, so they wrap
+ * consistently. Records were validated when posted.
+ */
+
+/* Hold the scanner off the posted state until _release_updates() */
+static void _hold_updates(vfd_t *vfd) {
+    vfd->posted.held = true;
+    __dmb();
+    while (vfd->posted.rendering) {
+        tight_loop_contents();
+    }
 }
 
-vfd_error_t vfd_refresh(void) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+static void _release_updates(vfd_t *vfd) {
+    __dmb();
+    vfd->posted.held = false;
+}
+
+/* Fold what the scanner took off the ring into the back buffer, then
+ * apply what is still queued, oldest first (scanner held off) */
+static void _drain_updates(vfd_t *vfd) {
+    vfd_posted_state_t *ps = &vfd->posted;
+    if (ps->steps != 0) {
+        for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+            uint8_t base = (uint8_t)(vfd->steps * chip);
+            for (uint8_t step = 0; step < vfd->steps; step++) {
+                if (ps->command_mask[chip] & (1u << step)) {
+                    _set_command(vfd, base + step, ps->commands[chip][step]);
+                }
+                if (ps->segment_mask[chip] & (1u << step)) {
+                    _set_grid(vfd, base + step, ps->segments[chip][step]);
+                }
+            }
+            ps->command_mask[chip] = 0;
+            ps->segment_mask[chip] = 0;
+        }
+        ps->steps = 0;
     }
 
-    for (uint8_t grid = 0; grid < 9; grid++) {
-        _write_vfd_raw(grid, g_vfd_state.display_buffer[grid]);
-        sleep_us(g_vfd_state.config.refresh_interval_us);
+    uint16_t tail = vfd->update_tail;
+    uint16_t head = vfd->update_head;
+    if (tail == head) {
+        return;
     }
 
-    return VFD_OK;
+    __dmb();
+    for (; tail != head; tail++) {
+        const vfd_update_t *update = &vfd->updates[tail % VFD_UPDATE_QUEUE_SIZE];
+        uint8_t base = (uint8_t)(vfd->steps * update->chip);
+        for (uint8_t i = 0; i < vfd->steps; i++) {
+            if (!(update->mask & (1u << i))) {
+                continue;
+            }
+            if (update->kind == VFD_UPDATE_COMMAND) {
+                _set_command(vfd, base + i, update->data[0]);
+            } else {
+                _set_grid(vfd, base + i, update->data[i]);
+            }
+        }
+    }
+    __dmb();
+    vfd->update_tail = tail;
 }
 
-vfd_error_t vfd_write_string(const char *str) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Encode the dirty grids of the back buffer and publish it */
+static void _commit_frame(vfd_t *vfd) {
+    /* The scanner keeps sending what it had posted until this commit is
+     * published, so folded records never drop out for a frame */
+    _hold_updates(vfd);
+    _drain_updates(vfd);
+
+    uint16_t mask = vfd->buffer_shared ? vfd->all_steps : vfd->dirty;
+    if (mask == 0) {
+        _release_updates(vfd);
+        return;
     }
 
-    if (str == NULL) {
-        return VFD_ERR_INVALID_PARAM;
+    uint8_t index = vfd->back;
+    vfd_frame_t *frame = &vfd->frames[index];
+    for (uint8_t grid = 0; grid < vfd->steps; grid++) {
+        if (mask & (1u << grid)) {
+            _encode_grid(vfd, frame, grid);
+        }
+    }
+    _schedule_frame(vfd, frame);
+
+    for (uint8_t i = 0; i < VFD_FRAME_COUNT; i++) {
+        if (i != index) {
+            vfd->stale[i] |= mask;
+        }
     }
 
-    vfd_clear();
+    vfd->dirty = 0;
+    vfd->buffer_shared = false;
+
+    _publish_frame(vfd, index);
+    _rotate_back(vfd);
+    _release_updates(vfd);
+}
+
+/* Scan steps that grids [first, first + count) fall on */
+static uint16_t _window_steps(const vfd_t *vfd, uint8_t first, uint8_t count) {
+    uint16_t steps = 0;
+    for (uint8_t grid = first; grid < first + count; grid++) {
+        steps |= (uint16_t)(1u << (vfd->grid_slot[grid] & 0x0F));
+    }
+    return steps;
+}
+
+/* Encode the lit burst of one step drawn over frame
+ * Grids [first, first + width) show glyphs[] instead of their committed
+ * patterns; everything else on the step, other chips included, comes from
+ * the frame. Used by the overlays the scanner keeps (marquee and clock).
+ */
+static void _encode_overlay(const vfd_t *vfd, const vfd_frame_t *frame, uint8_t step,
+                            uint8_t first, uint8_t width, const uint8_t *glyphs,
+                            uint8_t *burst) {
+    uint32_t words[VFD_CHAIN_MAX] = {0};
+    for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+        words[chip] = vfd->command_bits[frame->commands[chip][step]];
+        if (frame->levels[step] == 0) {
+            continue;
+        }
+        uint8_t grid = (uint8_t)(vfd->steps * chip + step);
+        uint8_t segments = frame->segments[chip][step];
+        if (grid >= first && grid < first + width) {
+            segments = glyphs[grid - first];
+        }
+        words[chip] |= vfd->grid_bits[step] | _segment_word(vfd, segments);
+    }
+    _pack_burst(vfd, burst, words);
+}
 
-    uint8_t grid = 0;
-    for (size_t i = 0; str[i] != '\0' && grid < 9; i++) {
-        char c = str[i];
-        vfd_error_t err;
+/* Take the queued records into the posted state (scanner side)
+ * Returns the steps they touched. */
+static uint16_t _take_updates(vfd_t *vfd) {
+    uint16_t tail = vfd->update_tail;
+    uint16_t head = vfd->update_head;
+    if (tail == head) {
+        return 0;
+    }
 
-        if (c >= '0' && c <= '9') {
-            err = vfd_write_digit(grid, c - '0');
-            if (err != VFD_OK) {
-                return err;
+    vfd_posted_state_t *ps = &vfd->posted;
+    uint16_t touched = 0;
+    __dmb();
+    for (; tail != head; tail++) {
+        const vfd_update_t *update = &vfd->updates[tail % VFD_UPDATE_QUEUE_SIZE];
+        uint8_t chip = update->chip;
+        for (uint8_t i = 0; i < vfd->steps; i++) {
+            if (!(update->mask & (1u << i))) {
+                continue;
             }
-            grid++;
-        } else if (c == '-') {
-            g_vfd_state.display_buffer[grid] = VFD_SYMBOL_DASH;
-            grid++;
-        } else if (c == '.') {
-            if (grid > 0) {
-                g_vfd_state.display_buffer[grid - 1] |= VFD_SYMBOL_DOT;
+            if (update->kind == VFD_UPDATE_COMMAND) {
+                ps->commands[chip][i] = update->data[0];
+                ps->command_mask[chip] |= (uint16_t)(1u << i);
+            } else {
+                ps->segments[chip][i] = update->data[i];
+                ps->segment_mask[chip] |= (uint16_t)(1u << i);
             }
-        } else if (c == ' ') {
-            g_vfd_state.display_buffer[grid] = VFD_BLANK;
-            grid++;
         }
+        touched |= update->mask;
     }
+    __dmb();
+    vfd->update_tail = tail;
+    ps->steps |= touched;
+    return touched;
+}
 
-    return VFD_OK;
+/* Encode the lit and blank bursts of one step with the posted patterns and
+ * command bits in place of the frame's */
+static void _encode_posted(vfd_t *vfd, const vfd_frame_t *frame, uint8_t step) {
+    vfd_posted_state_t *ps = &vfd->posted;
+    uint32_t lit[VFD_CHAIN_MAX] = {0};
+    uint32_t blank[VFD_CHAIN_MAX] = {0};
+    for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+        uint8_t command = (ps->command_mask[chip] & (1u << step)) ? ps->commands[chip][step]
+                                                                  : frame->commands[chip][step];
+        uint8_t segments = (ps->segment_mask[chip] & (1u << step)) ? ps->segments[chip][step]
+                                                                   : frame->segments[chip][step];
+        blank[chip] = vfd->command_bits[command];
+        lit[chip] = blank[chip];
+        if (frame->levels[step] > 0) {
+            lit[chip] |= vfd->grid_bits[step] | _segment_word(vfd, segments);
+        }
+    }
+    _pack_burst(vfd, ps->bursts[2 * step], lit);
+    _pack_burst(vfd, ps->bursts[2 * step + 1], blank);
 }
 
-vfd_display_buffer_t *vfd_get_buffer(void) {
-    if (!g_vfd_state.initialized) {
-        return NULL;
+/* Posted update upkeep at a frame boundary (scanner side, after the
+ * marquee and clock) */
+static void _posted_frame(vfd_t *vfd) {
+    vfd_posted_state_t *ps = &vfd->posted;
+
+    ps->rendering = true;
+    __dmb();
+    if (ps->held) {
+        __dmb();
+        ps->rendering = false;
+        return;
+    }
+
+    uint16_t changed = _take_updates(vfd);
+    ps->fresh = (changed != 0);
+
+    const vfd_frame_t *frame = _scan_source(vfd);
+    if (frame != ps->rendered_frame) {
+        changed = ps->steps;
+        ps->rendered_frame = frame;
     }
-    return &g_vfd_state.display_buffer;
+    for (uint8_t step = 0; changed != 0; step++, changed >>= 1) {
+        if (changed & 1) {
+            _encode_posted(vfd, frame, step);
+        }
+    }
+
+    /* A marquee window or clock face covers what is posted under it */
+    ps->scan_mask = ps->steps & (uint16_t)~(vfd->marquee.scan_mask | vfd->clock.scan_mask);
+    __dmb();
+    ps->rendering = false;
 }
 
-vfd_error_t vfd_fill_buffer(uint8_t segments) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Marquee
+ * The application renders glyphs into the strip and advances head; the
+ * scanner advances pos and owns bursts[] and scan_mask. The rendering flag
+ * brackets the scanner's use of the strip, like latching does for front, so
+ * start and stop can wait out core 1 before changing what it reads.
+ */
+
+/* Glyphs text takes in the strip, with the same '.' folding as below */
+static uint32_t _strip_count(const char *str, bool can_fold) {
+    uint32_t count = 0;
+    for (const char *p = str; *p != '\0'; p++) {
+        if (*p == '.' && can_fold) {
+            can_fold = false;
+            continue;
+        }
+        can_fold = (*p != '.');
+        count++;
     }
+    return count;
+}
 
-    memset(g_vfd_state.display_buffer, segments, sizeof(vfd_display_buffer_t));
-    return VFD_OK;
+/* Render text into the strip from head on, without moving head
+ * A '.' after a glyph lights that glyph's decimal point, as in
+ * vfd_write_string(), also across appends.
+ */
+static void _strip_render(vfd_marquee_state_t *mq, const char *str) {
+    uint32_t at = mq->head;
+    bool can_fold = mq->can_fold;
+
+    for (const char *p = str; *p != '\0'; p++) {
+        uint8_t c = (uint8_t)*p;
+        if (c == '.' && can_fold) {
+            mq->strip[(at - 1) % mq->length] |= VFD_SYMBOL_DOT;
+            can_fold = false;
+            continue;
+        }
+        mq->strip[at % mq->length] = ASCII_FONT[c];
+        can_fold = (c != '.');
+        at++;
+    }
+    mq->can_fold = can_fold;
 }
 
-vfd_error_t vfd_send_control_command(const vfd_control_command_t *cmd) {
-    if (!g_vfd_state.initialized) {
-        return VFD_ERR_NOT_INITIALIZED;
+/* Store blank glyphs from head on */
+static void _strip_blank(vfd_marquee_state_t *mq, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        mq->strip[(mq->head + i) % mq->length] = VFD_BLANK;
     }
+    mq->head += count;
+    mq->can_fold = false;
+}
 
-    if (cmd == NULL) {
-        return VFD_ERR_INVALID_PARAM;
+/* Glyph at strip position index; a stream shows blank past its head */
+static uint8_t _marquee_glyph(const vfd_marquee_state_t *mq, uint32_t head, uint32_t index) {
+    if (!mq->loop && index >= head) {
+        return VFD_BLANK;
     }
+    return mq->strip[index % mq->length];
+}
 
-    if (cmd->command > 7) {
-        return VFD_ERR_INVALID_PARAM;
+/* Move the window one grid; false if a stream has nothing new to show */
+static bool _marquee_advance(vfd_marquee_state_t *mq, uint32_t head) {
+    if (mq->loop) {
+        mq->pos = (mq->direction == VFD_SCROLL_LEFT) ? (mq->pos + 1) % mq->length
+                                                     : (mq->pos + mq->length - 1) % mq->length;
+        return true;
     }
+    if (mq->pos + mq->width >= head) {
+        return false;
+    }
+    mq->pos++;
+    return true;
+}
 
-    /* Encode command in bits 19-17 and send with zero grid/segment data.
-     * User can define what each command code (0-7) does in their application.
-     * Transmits 3 bytes (24 bits): 4 padding bits + 20-bit control word.
-     * The padding bits position the command in the shift register correctly.
-     */
-    uint32_t control_word = ((uint32_t)cmd->command << 17);
-    
-    g_vfd_state.spi_data[0] = (control_word >> 16) & 0xFF;
-    g_vfd_state.spi_data[1] = (control_word >> 8) & 0xFF;
-    g_vfd_state.spi_data[2] = control_word & 0xFF;
+/* Marquee upkeep at a frame boundary (scanner side, after latching front)
+ * Steps the window when due and re-encodes the lit words of the steps it
+ * covers only if the window moved, the strip changed or a new commit was
+ * latched underneath it.
+ */
+static void _marquee_frame(vfd_t *vfd) {
+    vfd_marquee_state_t *mq = &vfd->marquee;
+
+    mq->rendering = true;
+    __dmb();
+    if (!mq->active) {
+        mq->scan_mask = 0;
+        __dmb();
+        mq->rendering = false;
+        return;
+    }
 
-    spi_write_blocking(g_vfd_state.spi_port, g_vfd_state.spi_data, 3);
+    uint32_t head = mq->head;
+    uint32_t gen = mq->gen;
+    const vfd_frame_t *frame = _scan_source(vfd);
+    bool changed = (gen != mq->rendered_gen) || (frame != mq->rendered_frame);
 
-    gpio_put(g_vfd_state.config.pin_latch, 1);
-    sleep_us(1);
-    gpio_put(g_vfd_state.config.pin_latch, 0);
+    uint64_t now = max6921_hal_time_us();
+    if (now >= mq->next_step && _marquee_advance(mq, head)) {
+        mq->next_step += mq->step_us;
+        if (mq->next_step <= now) {
+            mq->next_step = now + mq->step_us;   /* Fell behind: no catch-up burst */
+        }
+        changed = true;
+    }
 
-    return VFD_OK;
+    if (changed) {
+        uint8_t window[VFD_GRIDS_MAX * VFD_CHAIN_MAX];
+        for (uint8_t i = 0; i < mq->width; i++) {
+            window[i] = _marquee_glyph(mq, head, mq->pos + i);
+        }
+        for (uint8_t step = 0; step < vfd->steps; step++) {
+            if (mq->steps & (1u << step)) {
+                _encode_overlay(vfd, frame, step, mq->first_grid, mq->width, window,
+                                mq->bursts[step]);
+            }
+        }
+        mq->rendered_gen = gen;
+        mq->rendered_frame = frame;
+    }
+
+    mq->scan_mask = mq->steps;
+    __dmb();
+    mq->rendering = false;
 }
 
-int vfd_segments_to_string(uint8_t segments, char *buffer, int buffer_size) {
-    if (buffer == NULL || buffer_size < 1) {
-        return 0;
+/* Deactivate the marquee and wait until core 1 no longer reads the strip */
+static void _marquee_quiesce(vfd_t *vfd) {
+    vfd->marquee.active = false;
+    __dmb();
+    while (vfd->marquee.rendering) {
+        tight_loop_contents();
     }
+}
 
-    static const char *segment_names[] = {"A", "B", "C", "D", "E", "F", "G", "H"};
-    int offset = 0;
+/* Clock
+ * The source only moves a seconds count on: an IRQ bumps ticks (PPS) or
+ * stores the RTC's time of day, and the timer source is the scanner
+ * stepping next_tick on absolute deadlines. The scanner owns the glyphs
+ * and bursts[]; the application changes the rest only while the clock is
+ * quiesced, the same way as the marquee.
+ */
 
-    buffer[0] = '\0';
+#define VFD_CLOCK_DAY 86400u
 
-    for (int i = 0; i < 8; i++) {
-        if (segments & (1 << i)) {
-            if (offset > 0) {
-                offset += snprintf(buffer + offset, buffer_size - offset, " ");
-            }
-            offset += snprintf(buffer + offset, buffer_size - offset, "%s", segment_names[i]);
+/* Grids each layout takes */
+static const uint8_t CLOCK_WIDTHS[3] = {8, 5, 6};
 
-            if (offset >= buffer_size - 1) {
-                break;
-            }
+/* Glyphs of the clock face for a time of day in seconds */
+static void _clock_render(const vfd_clock_state_t *ck, uint32_t time, uint8_t *glyphs) {
+    uint32_t hours = time / 3600u;
+    uint32_t rest = time - hours * 3600u;
+    uint32_t minutes = rest / 60u;
+    uint32_t seconds = rest - minutes * 60u;
+    bool pm = hours >= 12;
+
+    if (ck->hour12) {
+        hours = (hours % 12u == 0) ? 12u : hours % 12u;
+    }
+    uint8_t h1 = (ck->hour12 && hours < 10) ? VFD_BLANK : DIGIT_PATTERNS[hours / 10];
+    uint8_t h0 = DIGIT_PATTERNS[hours % 10];
+    uint8_t m1 = DIGIT_PATTERNS[minutes / 10];
+    uint8_t m0 = DIGIT_PATTERNS[minutes % 10];
+    uint8_t s1 = DIGIT_PATTERNS[seconds / 10];
+    uint8_t s0 = DIGIT_PATTERNS[seconds % 10];
+
+    switch (ck->layout) {
+    case VFD_CLOCK_HH_MM:
+        glyphs[0] = h1;
+        glyphs[1] = h0;
+        glyphs[2] = VFD_SYMBOL_DASH;
+        glyphs[3] = m1;
+        glyphs[4] = m0;
+        break;
+    case VFD_CLOCK_HH_MM_SS_DOTS:
+        glyphs[0] = h1;
+        glyphs[1] = h0 | VFD_SYMBOL_DOT;
+        glyphs[2] = m1;
+        glyphs[3] = m0 | VFD_SYMBOL_DOT;
+        glyphs[4] = s1;
+        glyphs[5] = s0;
+        break;
+    default:
+        glyphs[0] = h1;
+        glyphs[1] = h0;
+        glyphs[2] = VFD_SYMBOL_DASH;
+        glyphs[3] = m1;
+        glyphs[4] = m0;
+        glyphs[5] = VFD_SYMBOL_DASH;
+        glyphs[6] = s1;
+        glyphs[7] = s0;
+        break;
+    }
+
+    if (ck->hour12 && pm) {
+        glyphs[ck->width - 1] |= VFD_SYMBOL_DOT;
+    }
+}
+
+/* Clock upkeep at a frame boundary (scanner side, after latching front)
+ * Takes the seconds that have passed, rebuilds the face only when the time
+ * moved, and re-encodes just the steps whose glyph changed; all of its
+ * steps only when a new commit was latched underneath.
+ */
+static void _clock_frame(vfd_t *vfd) {
+    vfd_clock_state_t *ck = &vfd->clock;
+
+    ck->rendering = true;
+    __dmb();
+    if (!ck->active) {
+        ck->scan_mask = 0;
+        __dmb();
+        ck->rendering = false;
+        return;
+    }
+
+    if (ck->source == VFD_CLOCK_TIMER) {
+        uint64_t now = max6921_hal_time_us();
+        while (now >= ck->next_tick) {
+            ck->next_tick += 1000000u;
+            ck->ticks++;
         }
     }
 
-    return offset;
+    uint16_t changed = 0;
+    uint32_t count = (ck->source == VFD_CLOCK_RTC) ? ck->rtc_time : ck->ticks;
+    if (ck->redraw || count != ck->shown) {
+        uint32_t time = count;
+        if (ck->source != VFD_CLOCK_RTC) {
+            time = (ck->base_time + (count - ck->base_ticks)) % VFD_CLOCK_DAY;
+        }
+        uint8_t glyphs[8];
+        _clock_render(ck, time, glyphs);
+        for (uint8_t i = 0; i < ck->width; i++) {
+            if (ck->redraw || glyphs[i] != ck->glyphs[i]) {
+                ck->glyphs[i] = glyphs[i];
+                changed |= (uint16_t)(1u << (vfd->grid_slot[ck->first_grid + i] & 0x0F));
+            }
+        }
+        ck->shown = count;
+        ck->redraw = false;
+    }
+
+    const vfd_frame_t *frame = _scan_source(vfd);
+    if (frame != ck->rendered_frame) {
+        changed = ck->steps;
+        ck->rendered_frame = frame;
+    }
+    for (uint8_t step = 0; changed != 0; step++, changed >>= 1) {
+        if (changed & 1) {
+            _encode_overlay(vfd, frame, step, ck->first_grid, ck->width, ck->glyphs,
+                            ck->bursts[step]);
+        }
+    }
+
+    ck->scan_mask = ck->steps;
+    __dmb();
+    ck->rendering = false;
+}
+
+/* Deactivate the clock and wait until core 1 no longer reads it */
+static void _clock_quiesce(vfd_t *vfd) {
+    vfd->clock.active = false;
+    __dmb();
+    while (vfd->clock.rendering) {
+        tight_loop_contents();
+    }
+}
+
+#if !MAX6921_HOST
+/* RTC alarm: take the time and match the next second
+ * The SDK's alarm has no user data, hence the owner pointer. */
+static void _clock_rtc_alarm(void) {
+    vfd_clock_state_t *ck = &g_vfd_clock_owner->clock;
+    datetime_t now;
+    rtc_get_datetime(&now);
+    ck->rtc_time = (uint32_t)now.hour * 3600u + (uint32_t)now.min * 60u + (uint32_t)now.sec;
+
+    datetime_t alarm = {
+        .year = -1, .month = -1, .day = -1, .dotw = -1, .hour = -1, .min = -1,
+        .sec = (int8_t)((now.sec + 1) % 60)
+    };
+    rtc_set_alarm(&alarm, _clock_rtc_alarm);
+}
+
+/* PPS edge: one second has passed */
+static void _clock_pps_irq(void) {
+    vfd_clock_state_t *ck = &g_vfd_clock_owner->clock;
+    if (gpio_get_irq_event_mask(ck->pin_pps) & GPIO_IRQ_EDGE_RISE) {
+        gpio_acknowledge_irq(ck->pin_pps, GPIO_IRQ_EDGE_RISE);
+        ck->ticks++;
+    }
+}
+
+/* Hook the clock's source up; the timer source needs nothing */
+static vfd_error_t _clock_claim(vfd_t *vfd) {
+    vfd_clock_state_t *ck = &vfd->clock;
+    if (ck->source == VFD_CLOCK_TIMER) {
+        return VFD_OK;
+    }
+    if (g_vfd_clock_owner != NULL) {
+        return VFD_ERR_BUSY;
+    }
+
+    if (ck->source == VFD_CLOCK_RTC) {
+        if (!rtc_running()) {
+            return VFD_ERR_HARDWARE;
+        }
+        g_vfd_clock_owner = vfd;
+        _clock_rtc_alarm();
+        return VFD_OK;
+    }
+
+    g_vfd_clock_owner = vfd;
+    gpio_init(ck->pin_pps);
+    gpio_set_dir(ck->pin_pps, GPIO_IN);
+    gpio_add_raw_irq_handler(ck->pin_pps, _clock_pps_irq);
+    gpio_set_irq_enabled(ck->pin_pps, GPIO_IRQ_EDGE_RISE, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    return VFD_OK;
+}
+
+/* Give the RTC alarm or PPS pin back */
+static void _clock_release(vfd_t *vfd) {
+    if (g_vfd_clock_owner != vfd) {
+        return;
+    }
+    if (vfd->clock.source == VFD_CLOCK_RTC) {
+        rtc_disable_alarm();
+    } else {
+        gpio_set_irq_enabled(vfd->clock.pin_pps, GPIO_IRQ_EDGE_RISE, false);
+        gpio_remove_raw_irq_handler(vfd->clock.pin_pps, _clock_pps_irq);
+    }
+    g_vfd_clock_owner = NULL;
+}
+
+/* The RTC source's time is the RTC's own; keep its date */
+static vfd_error_t _clock_set_rtc(vfd_t *vfd, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    datetime_t now;
+    if (!rtc_get_datetime(&now)) {
+        return VFD_ERR_HARDWARE;
+    }
+    now.hour = (int8_t)hours;
+    now.min = (int8_t)minutes;
+    now.sec = (int8_t)seconds;
+    if (!rtc_set_datetime(&now)) {
+        return VFD_ERR_HARDWARE;
+    }
+    vfd->clock.rtc_time = (uint32_t)hours * 3600u + (uint32_t)minutes * 60u + seconds;
+    return VFD_OK;
+}
+#else
+/* No RTC or GPIO IRQs on the host; only the timer source runs */
+static vfd_error_t _clock_claim(vfd_t *vfd) {
+    return (vfd->clock.source == VFD_CLOCK_TIMER) ? VFD_OK : VFD_ERR_UNSUPPORTED;
+}
+static void _clock_release(vfd_t *vfd) { (void)vfd; }
+static vfd_error_t _clock_set_rtc(vfd_t *vfd, uint8_t hours, uint8_t minutes,
+                                  uint8_t seconds) {
+    (void)vfd;
+    (void)hours;
+    (void)minutes;
+    (void)seconds;
+    return VFD_ERR_UNSUPPORTED;
+}
+#endif
+
+/* Take the clock off the display and release its source */
+static void _clock_stop(vfd_t *vfd) {
+    _clock_quiesce(vfd);
+    _clock_release(vfd);
+}
+
+/* Transitions
+ * The player renders stage index of stage_count from the frame the
+ * transition started from (from[]) and the latest commit. Stage 0 is the
+ * old frame, shown until the first hold is over; the commit itself
+ * follows the last stage.
+ */
+
+/* Fade stages: one per frame of the duration, within these bounds */
+#define VFD_FADE_STAGES_MIN 2
+#define VFD_FADE_STAGES_MAX 32
+
+/* A 7-segment digit as five rows: A; F, B; G; E, C; D */
+static const uint8_t ROLL_ROWS[5][2] = {
+    {0x01, 0x00}, {0x20, 0x02}, {0x40, 0x00}, {0x10, 0x04}, {0x08, 0x00},
+};
+
+/* Digit rolled up by offset rows (0, 2, 4 or 6) from one glyph to the next
+ * The two glyphs are stacked with a blank row 5 between them, which keeps
+ * horizontal rows on horizontal segments; the point changes halfway.
+ */
+static uint8_t _roll_glyph(uint8_t from, uint8_t to, uint8_t offset) {
+    uint8_t out = (offset < 4 ? from : to) & VFD_SYMBOL_DOT;
+    for (uint8_t row = 0; row < 5; row++) {
+        uint8_t src = row + offset;
+        if (src == 5) {
+            continue;
+        }
+        uint8_t glyph = (src < 5) ? from : to;
+        const uint8_t *src_row = ROLL_ROWS[(src < 5) ? src : src - 6];
+        for (uint8_t i = 0; i < 2; i++) {
+            if (glyph & src_row[i]) {
+                out |= ROLL_ROWS[row][i];
+            }
+        }
+    }
+    return out;
+}
+
+/* Stages a transition takes, the old frame included */
+static uint16_t _transition_stages(const vfd_t *vfd, vfd_transition_t type,
+                                   uint32_t duration_ms) {
+    if (type == VFD_TRANSITION_ROLL) {
+        return 3;
+    }
+    if (type == VFD_TRANSITION_SLIDE || type == VFD_TRANSITION_WIPE) {
+        return vfd->grid_count;
+    }
+
+    uint32_t stages = (uint32_t)(((uint64_t)duration_ms * 1000u) / vfd->frame_us);
+    if (stages < VFD_FADE_STAGES_MIN) {
+        stages = VFD_FADE_STAGES_MIN;
+    } else if (stages > VFD_FADE_STAGES_MAX) {
+        stages = VFD_FADE_STAGES_MAX;
+    }
+    return (uint16_t)stages;
+}
+
+/* Pattern of tube grid grid in a ROLL, SLIDE or WIPE stage */
+static uint8_t _transition_glyph(const vfd_t *vfd, const vfd_frame_t *to, uint8_t grid,
+                                 uint16_t index) {
+    const vfd_player_state_t *pl = &vfd->player;
+    uint8_t slot = vfd->grid_slot[grid];
+    uint8_t from = pl->from[slot >> 4][slot & 0x0F];
+    uint8_t target = to->segments[slot >> 4][slot & 0x0F];
+
+    if (pl->transition == VFD_TRANSITION_ROLL) {
+        return (from == target) ? target : _roll_glyph(from, target, (uint8_t)(2 * index));
+    }
+    if (pl->transition == VFD_TRANSITION_WIPE) {
+        return (grid < index) ? target : from;
+    }
+
+    /* SLIDE: the old frame followed by the new one, seen from grid index */
+    uint16_t src = grid + index;
+    if (src < vfd->grid_count) {
+        slot = vfd->grid_slot[src];
+        return pl->from[slot >> 4][slot & 0x0F];
+    }
+    slot = vfd->grid_slot[src - vfd->grid_count];
+    return to->segments[slot >> 4][slot & 0x0F];
+}
+
+/* Lit control words of one step for the given patterns, at a level above 0 */
+static void _step_words(const vfd_t *vfd, const vfd_frame_t *frame, uint8_t step,
+                        const vfd_display_buffer_t *segments, uint32_t *words) {
+    for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+        words[chip] = vfd->command_bits[frame->commands[chip][step]] | vfd->grid_bits[step] |
+                      _segment_word(vfd, segments[chip][step]);
+    }
+}
+
+/* Encode a FADE stage
+ * The stage is first encoded and scheduled with old and new patterns
+ * merged, so the adaptive scan modes visit every grid lit in either.
+ * Changed steps whose lit word fills the slot then send the old words
+ * for (count - index) / count of it and the new ones, in place of the
+ * blank word, for the rest. Other changed steps have a blank part to keep,
+ * so they fade through dark: the old words dim out over the first half
+ * of the stages and the new ones in over the second. Steps under a
+ * marquee window or clock face are left to the overlay.
+ */
+static void _fade_stage(vfd_t *vfd, vfd_frame_t *stage, const vfd_frame_t *to,
+                        uint16_t index) {
+    const vfd_player_state_t *pl = &vfd->player;
+    uint32_t count = pl->stage_count;
+    uint8_t chain = vfd->config.chain_length;
+
+    for (uint8_t chip = 0; chip < chain; chip++) {
+        for (uint8_t step = 0; step < vfd->steps; step++) {
+            stage->segments[chip][step] = pl->from[chip][step] | to->segments[chip][step];
+        }
+    }
+    for (uint8_t step = 0; step < vfd->steps; step++) {
+        _encode_grid(vfd, stage, step);
+    }
+    _schedule_frame(vfd, stage);
+
+    uint16_t overlay = vfd->marquee.scan_mask | vfd->clock.scan_mask | vfd->posted.scan_mask;
+    for (uint8_t step = 0; step < vfd->steps; step++) {
+        uint8_t level = stage->levels[step];
+        uint8_t from_level = pl->from_levels[step];
+        bool changed = (from_level != level);
+        for (uint8_t chip = 0; chip < chain; chip++) {
+            changed |= (pl->from[chip][step] != to->segments[chip][step]);
+        }
+        if (!changed || level == 0 || (overlay & (1u << step))) {
+            continue;
+        }
+
+        uint32_t old_words[VFD_CHAIN_MAX] = {0};
+        uint32_t new_words[VFD_CHAIN_MAX] = {0};
+        _step_words(vfd, stage, step, pl->from, old_words);
+        _step_words(vfd, stage, step, to->segments, new_words);
+
+        bool cross = level == VFD_BRIGHTNESS_MAX && from_level == VFD_BRIGHTNESS_MAX &&
+                     stage->on_us[step] == stage->slot_us[step];
+        const uint32_t *lit = old_words;
+        uint32_t num = count - index;
+        uint32_t den = count;
+        if (!cross && 2 * index >= count) {
+            lit = new_words;
+            num = 2 * index - count;
+        } else if (!cross) {
+            num = (count - 2 * index) * from_level;
+            den = count * level;
+        }
+        stage->on_us[step] = (uint32_t)(((uint64_t)stage->on_us[step] * num) / den);
+
+        if (vfd->config.backend != VFD_BACKEND_PIO) {
+            _pack_burst(vfd, stage->bursts[2 * step], lit);
+            if (cross) {
+                _pack_burst(vfd, stage->bursts[2 * step + 1], new_words);
+            }
+            continue;
+        }
+
+        /* The PIO words share the step's hold units the same way */
+        uint32_t on_units = (stage->words[2 * step] & 0xFFF) + 1;
+        uint32_t units = on_units + (stage->words[2 * step + 1] & 0xFFF) + 1;
+        on_units = (on_units * num) / den;
+        if (on_units < 1) {
+            on_units = 1;
+        } else if (on_units > units - 1) {
+            on_units = units - 1;
+        }
+        uint32_t off_units = units - on_units;
+        uint32_t blank = cross ? new_words[0] : stage->words[2 * step + 1] >> 12;
+        stage->words[2 * step] = _pack_word(lit[0], on_units);
+        stage->words[2 * step + 1] = _pack_word(blank, off_units);
+    }
+}
+
+/* Encode stage index of the running transition
+ * Levels and command bits come from the latest commit, which is still the
+ * old frame when stage 0 is encoded.
+ */
+static void _transition_stage(vfd_t *vfd, vfd_frame_t *stage, uint16_t index) {
+    const vfd_frame_t *to = &vfd->frames[vfd->ready];
+    memcpy(stage->levels, to->levels, sizeof(stage->levels));
+    memcpy(stage->commands, to->commands, sizeof(stage->commands));
+
+    if (vfd->player.transition == VFD_TRANSITION_FADE) {
+        _fade_stage(vfd, stage, to, index);
+        return;
+    }
+
+    for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+        uint8_t slot = vfd->grid_slot[grid];
+        stage->segments[slot >> 4][slot & 0x0F] = _transition_glyph(vfd, to, grid, index);
+    }
+    for (uint8_t step = 0; step < vfd->steps; step++) {
+        _encode_grid(vfd, stage, step);
+    }
+    _schedule_frame(vfd, stage);
+}
+
+/* Animation player
+ * The player alarm encodes each frame as it comes due into the stage no
+ * scanner can be reading, then publishes it: to a CPU scanner through
+ * ready_stage, latched at grid 0 like ready, and to DMA through
+ * dma_frame_addr, which the control channel reloads every frame.
+ */
+
+/* Stage the scan engine is reading, -1 for the committed frames */
+static int8_t _player_scanning(vfd_t *vfd) {
+    if (vfd->engine != VFD_ENGINE_DMA) {
+        _wait_latch(vfd);
+        return vfd->player.scan_stage;
+    }
+
+#if !MAX6921_HOST
+    uintptr_t addr = _dma_read_addr(vfd);
+    for (int8_t i = 0; i < 2; i++) {
+        if (_dma_reads(addr, &vfd->player.stage[i])) {
+            return i;
+        }
+    }
+#endif
+    return -1;
+}
+
+/* Hand the scan back to the committed frames */
+static void _player_release(vfd_t *vfd) {
+    vfd->player.active = false;
+    vfd->player.ready_stage = -1;
+    __dmb();
+    if (vfd->engine == VFD_ENGINE_DMA) {
+        vfd->dma_frame_addr = vfd->frames[vfd->ready].words;
+    }
+}
+
+/* Player alarm callback
+ * Runs in IRQ context once per animation frame. Its negative return keeps
+ * hold times drift-free; if the scanner has not picked up the previous
+ * stage yet, it tries again one grid slot later.
+ */
+static int64_t _player_alarm(int32_t id, void *user_data) {
+    (void)id;
+    vfd_t *vfd = (vfd_t *)user_data;
+    vfd_player_state_t *pl = &vfd->player;
+    const vfd_animation_t *animation = pl->animation;
+    uint16_t count = (animation != NULL) ? animation->frame_count : pl->stage_count;
+
+    if (pl->index >= count) {
+        _player_release(vfd);
+        if (pl->on_done != NULL) {
+            pl->on_done(vfd, pl->user_data);
+        }
+        return 0;
+    }
+
+    int8_t ready = pl->ready_stage;
+    int8_t scanning = _player_scanning(vfd);
+    int8_t target = (ready != 0 && scanning != 0) ? 0 : 1;
+    if (target == ready || target == scanning) {
+        return vfd->config.refresh_interval_us;
+    }
+
+    vfd_frame_t *stage = &pl->stage[target];
+    uint32_t hold_us = pl->hold_us;
+    if (animation != NULL) {
+        /* The first chip's grids from the animation; the rest from the commit */
+        const vfd_anim_frame_t *next = &animation->frames[pl->index];
+        const vfd_frame_t *committed = &vfd->frames[vfd->ready];
+        memcpy(stage->segments, committed->segments, sizeof(stage->segments));
+        memcpy(stage->segments[0], next->segments, sizeof(stage->segments[0]));
+        memcpy(stage->levels, committed->levels, sizeof(stage->levels));
+        memcpy(stage->commands, committed->commands, sizeof(stage->commands));
+        for (uint8_t grid = 0; grid < vfd->steps; grid++) {
+            _encode_grid(vfd, stage, grid);
+        }
+        _schedule_frame(vfd, stage);
+        hold_us = (uint32_t)next->hold_ms * 1000u;
+    } else {
+        _transition_stage(vfd, stage, pl->index);
+    }
+
+    __dmb();
+    pl->ready_stage = target;
+    if (vfd->engine == VFD_ENGINE_DMA) {
+        vfd->dma_frame_addr = stage->words;
+    }
+
+    pl->index++;
+    if (animation != NULL && pl->index >= count && animation->loop) {
+        pl->index = 0;
+    }
+    return -(int64_t)hold_us;
+}
+
+/* Cancel a playing animation without calling its completion callback */
+static void _player_stop(vfd_t *vfd) {
+    if (!vfd->player.active) {
+        return;
+    }
+    max6921_hal_alarm_cancel(vfd->player.alarm_id);
+    _player_release(vfd);
+}
+
+/* Low power
+ * Each frame start checks whether anything changed since the last one. Once
+ * nothing has been committed for idle_after_ms and no marquee or animation
+ * runs, the display is static: every slot, lit part included, stretches by
+ * the same factor so the frame rate drops to idle_fps at unchanged duty.
+ * With low_power, a static frame that lights nothing parks the engine.
+ * Returns true to park.
+ */
+static bool _idle_frame(vfd_t *vfd, uint64_t now) {
+    uint32_t seq = vfd->commit_seq;
+    vfd->scan_scale = 256;
+    if (seq != vfd->seen_seq || vfd->marquee.active || vfd->clock.active ||
+        vfd->player.active || vfd->posted.fresh ||
+        (vfd->queued_command & VFD_COMMAND_QUEUED)) {
+        vfd->seen_seq = seq;
+        vfd->seen_us = now;
+        return false;
+    }
+    if (now - vfd->seen_us < (uint64_t)vfd->config.idle_after_ms * 1000u) {
+        return false;
+    }
+
+    const vfd_frame_t *frame = _scan_source(vfd);
+    if (vfd->config.low_power && frame->lit_mask == 0 && vfd->posted.scan_mask == 0) {
+        return true;
+    }
+    if (vfd->idle_frame_us > frame->period_us) {
+        vfd->scan_scale = (uint32_t)(((uint64_t)vfd->idle_frame_us << 8) / frame->period_us);
+    }
+    return false;
+}
+
+/* A slot or lit time of the current frame, stretched to the idle floor */
+static inline uint32_t _stretch(const vfd_t *vfd, uint32_t us) {
+    if (vfd->scan_scale == 256) {
+        return us;
+    }
+    return (uint32_t)(((uint64_t)us * vfd->scan_scale) >> 8);
+}
+
+/* Forget what the scanner saw; idle time counts from now */
+static void _idle_reset(vfd_t *vfd) {
+    vfd->seen_seq = vfd->commit_seq;
+    vfd->seen_us = max6921_hal_time_us();
+    vfd->scan_scale = 256;
+    vfd->parked = false;
+}
+
+/* Timing statistics
+ * Only the one context that scans (caller, timer ISR or core 1) writes them,
+ * bracketing each update with an odd sequence count for lock-free readers.
+ * Without MAX6921_STATS every hook is an empty inline and the scan paths
+ * compile exactly as before.
+ */
+#if MAX6921_STATS
+static void _stat_add(vfd_stat_acc_t *acc, uint32_t value) {
+    if (acc->count == 0 || value < acc->min) {
+        acc->min = value;
+    }
+    if (value > acc->max) {
+        acc->max = value;
+    }
+    acc->count++;
+    acc->sum += value;
+}
+
+static uint32_t _stat_avg(const vfd_stat_acc_t *acc) {
+    return acc->count ? (uint32_t)(acc->sum / acc->count) : 0;
+}
+
+/* Zero everything measured, keeping the sequence count and timer target */
+static void _stats_clear(vfd_stats_state_t *st) {
+    uint32_t seq = st->seq;
+    uint64_t target = st->target;
+    memset((void *)st, 0, sizeof(*st));
+    st->seq = seq;
+    st->target = target;
+}
+
+static void _stats_begin(vfd_stats_state_t *st) {
+    st->seq++;
+    __dmb();
+    if (st->reset_pending) {
+        _stats_clear(st);
+    }
+}
+
+static void _stats_end(vfd_stats_state_t *st) {
+    __dmb();
+    st->seq++;
+}
+
+static inline uint64_t _stats_now(void) {
+    return max6921_hal_time_us();
+}
+
+static void _stats_init(vfd_t *vfd) {
+    memset((void *)&vfd->stats, 0, sizeof(vfd->stats));
+}
+
+/* A scan engine starts; the first step has nothing to measure against */
+static void _stats_restart(vfd_t *vfd, uint64_t first_due) {
+    vfd_stats_state_t *st = &vfd->stats;
+    _stats_begin(st);
+    st->frame_start = 0;
+    st->step_start = 0;
+    st->target = first_due;
+    _stats_end(st);
+}
+
+static void _stats_spi(vfd_t *vfd, uint64_t start) {
+    vfd_stats_state_t *st = &vfd->stats;
+    _stats_begin(st);
+    _stat_add(&st->spi_us, (uint32_t)(max6921_hal_time_us() - start));
+    _stats_end(st);
+}
+
+/* Close the previous grid step (and frame, at grid 0) */
+static void _stats_step(vfd_t *vfd, uint8_t grid, bool first, uint64_t now) {
+    vfd_stats_state_t *st = &vfd->stats;
+    _stats_begin(st);
+    if (st->step_start != 0) {
+        uint8_t prev = st->step_grid;
+        uint32_t dwell = (uint32_t)(now - st->step_start);
+        _stat_add(&st->dwell_us, dwell);
+        st->grid_dwell_sum[prev] += dwell;
+        st->grid_dwell_count[prev]++;
+    }
+    if (first) {
+        if (st->frame_start != 0) {
+            uint32_t frame_us = (uint32_t)(now - st->frame_start);
+            _stat_add(&st->frame_us, frame_us);
+            st->frames++;
+            if (vfd->config.target_fps != 0 && !st->frame_idle &&
+                frame_us > vfd->frame_us + vfd->frame_us / 100) {
+                st->late++;
+            }
+        }
+        st->frame_start = now;
+        st->frame_idle = (vfd->scan_scale != 256);
+    }
+    st->step_start = now;
+    st->step_grid = grid;
+    _stats_end(st);
+}
+
+/* End of a blocking refresh: the frame stops here, not at the next call */
+static void _stats_frame_done(vfd_t *vfd) {
+    _stats_step(vfd, 0, true, max6921_hal_time_us());
+    vfd_stats_state_t *st = &vfd->stats;
+    _stats_begin(st);
+    st->frame_start = 0;
+    st->step_start = 0;
+    _stats_end(st);
+}
+
+/* Count a miss if the next scan deadline has already passed */
+static void _stats_deadline(vfd_t *vfd, uint64_t due) {
+    if (max6921_hal_time_us() > due) {
+        vfd_stats_state_t *st = &vfd->stats;
+        _stats_begin(st);
+        st->missed++;
+        _stats_end(st);
+    }
+}
+
+/* Timer engine: advance the tick target the way the alarm pool does */
+static void _stats_tick(vfd_t *vfd, uint64_t next_us) {
+    vfd->stats.target += next_us;
+    _stats_deadline(vfd, vfd->stats.target);
+}
+#else
+static inline uint64_t _stats_now(void) { return 0; }
+static inline void _stats_init(vfd_t *vfd) { (void)vfd; }
+static inline void _stats_restart(vfd_t *vfd, uint64_t first_due) { (void)vfd; (void)first_due; }
+static inline void _stats_spi(vfd_t *vfd, uint64_t start) { (void)vfd; (void)start; }
+static inline void _stats_step(vfd_t *vfd, uint8_t grid, bool first, uint64_t now) {
+    (void)vfd;
+    (void)grid;
+    (void)first;
+    (void)now;
+}
+static inline void _stats_frame_done(vfd_t *vfd) { (void)vfd; }
+static inline void _stats_deadline(vfd_t *vfd, uint64_t due) { (void)vfd; (void)due; }
+static inline void _stats_tick(vfd_t *vfd, uint64_t next_us) { (void)vfd; (void)next_us; }
+#endif
+
+/* Trace recorder
+ * Only the context that sends writes the ring, like the statistics. An
+ * entry is a timer read and two stores before head moves on, so it can
+ * stay enabled in the field. Without MAX6921_TRACE every hook is an empty
+ * inline.
+ */
+#if MAX6921_TRACE
+static inline void _trace_put(vfd_t *vfd, uint32_t data) {
+    vfd_trace_state_t *tr = &vfd->trace;
+    uint32_t head = tr->head;
+    vfd_trace_entry_t *entry = &tr->entries[head % MAX6921_TRACE_SIZE];
+    entry->time_us = max6921_hal_time_us_32();
+    entry->data = data;
+    __dmb();
+    tr->head = head + 1;
+}
+
+static void _trace_init(vfd_t *vfd) {
+    vfd->trace.head = 0;
+    vfd->trace.start = 0;
+}
+
+/* One entry per chip, each word read back out of the packed burst;
+ * chip 0's word ends the burst, every word spans at most three bytes */
+static void _trace_burst(vfd_t *vfd, const uint8_t *burst) {
+    const uint8_t *end = burst + vfd->burst_bytes - 1;
+    for (uint8_t chip = 0; chip < vfd->config.chain_length; chip++) {
+        uint32_t shift = 20u * chip;
+        const uint8_t *p = end - shift / 8;
+        uint32_t raw = p[0] | ((uint32_t)p[-1] << 8) | ((uint32_t)p[-2] << 16);
+        _trace_put(vfd, ((uint32_t)VFD_TRACE_WORD << 30) | ((uint32_t)chip << 28) |
+                            ((raw >> (shift % 8)) & 0xFFFFFu));
+    }
+}
+
+static inline void _trace_latch(vfd_t *vfd) {
+    _trace_put(vfd, (uint32_t)VFD_TRACE_LATCH << 30);
+}
+
+static inline void _trace_command(vfd_t *vfd, uint8_t command) {
+    _trace_put(vfd, ((uint32_t)VFD_TRACE_COMMAND << 30) | command);
+}
+
+/* Copy up to max entries from *next on, stopping before end
+ * Entries the writer overwrote first, or may be overwriting now, are left
+ * out; *next moves past everything looked at. Returns how many were copied.
+ */
+static uint32_t _trace_read(vfd_t *vfd, uint32_t *next, uint32_t end, vfd_trace_entry_t *out,
+                            uint32_t max_entries) {
+    vfd_trace_state_t *tr = &vfd->trace;
+    uint32_t first = *next;
+    if (end - first > MAX6921_TRACE_SIZE) {
+        first = end - MAX6921_TRACE_SIZE;
+    }
+    uint32_t count = end - first;
+    if (count > max_entries) {
+        count = max_entries;
+    }
+
+    __dmb();
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = tr->entries[(first + i) % MAX6921_TRACE_SIZE];
+    }
+    __dmb();
+
+    /* The writer may be filling slot head, which held entry head - size */
+    uint32_t head = tr->head;
+    uint32_t lost = 0;
+    if (head - first >= MAX6921_TRACE_SIZE) {
+        lost = head - first - MAX6921_TRACE_SIZE + 1;
+        if (lost > count) {
+            lost = count;
+        }
+        memmove(out, out + lost, (count - lost) * sizeof(out[0]));
+    }
+    *next = first + count;
+    return count - lost;
+}
+#else
+static inline void _trace_init(vfd_t *vfd) { (void)vfd; }
+static inline void _trace_burst(vfd_t *vfd, const uint8_t *burst) { (void)vfd; (void)burst; }
+static inline void _trace_latch(vfd_t *vfd) { (void)vfd; }
+static inline void _trace_command(vfd_t *vfd, uint8_t command) { (void)vfd; (void)command; }
+#endif
+
+/* Pulse the shared latch by hand, unless CSn already did
+ * Busy-waits for the pulse so it is also safe from the refresh timer IRQ
+ */
+static inline void _pulse_latch(vfd_t *vfd) {
+    if (vfd->config.latch == VFD_LATCH_GPIO) {
+        max6921_hal_gpio_put(vfd->config.pin_latch, 1);
+        max6921_hal_busy_wait_us(1);
+        max6921_hal_gpio_put(vfd->config.pin_latch, 0);
+    }
+}
+
+/* Shift one packed SPI burst out and latch it */
+static void _send_and_latch(vfd_t *vfd, const uint8_t *burst) {
+    uint64_t start = _stats_now();
+
+    _trace_burst(vfd, burst);
+    max6921_hal_spi_write(vfd->config.spi_index, burst, vfd->burst_bytes);
+    _trace_latch(vfd);
+    _pulse_latch(vfd);
+
+    _stats_spi(vfd, start);
+}
+
+/* Send a control word with zero grid/segment bits to every chip */
+static void _write_vfd_command(vfd_t *vfd, uint8_t command) {
+    _trace_command(vfd, command);
+    uint32_t words[VFD_CHAIN_MAX];
+    for (uint8_t chip = 0; chip < VFD_CHAIN_MAX; chip++) {
+        words[chip] = vfd->command_bits[command];
+    }
+
+    uint8_t burst[VFD_BURST_BYTES_MAX];
+    _pack_burst(vfd, burst, words);
+    _send_and_latch(vfd, burst);
+}
+
+/* A cached burst of the current step, with its queued command OR'd in */
+static const uint8_t *_step_burst(vfd_t *vfd, const uint8_t *burst) {
+    if (vfd->step_command == 0) {
+        return burst;
+    }
+
+    uint32_t words[VFD_CHAIN_MAX];
+    for (uint8_t chip = 0; chip < VFD_CHAIN_MAX; chip++) {
+        words[chip] = vfd->command_bits[vfd->step_command];
+    }
+    _pack_burst(vfd, vfd->step_burst, words);
+    for (uint8_t i = 0; i < vfd->burst_bytes; i++) {
+        vfd->step_burst[i] |= burst[i];
+    }
+    return vfd->step_burst;
+}
+
+/* Start a scan step and pick its lit burst
+ * first marks the first step of a frame. A queued command is taken here and
+ * applies to this step's lit and blank words.
+ */
+static const uint8_t *_lit_burst(vfd_t *vfd, uint8_t grid, bool first) {
+    _stats_step(vfd, grid, first, _stats_now());
+
+    uint8_t queued = vfd->queued_command;
+    vfd->step_command = queued & 0x7;
+    if (queued & VFD_COMMAND_QUEUED) {
+        vfd->queued_command = 0;
+    }
+
+    /* Steps under a marquee window or clock face send the scanner's own lit word */
+    if (vfd->marquee.scan_mask & (1u << grid)) {
+        return _step_burst(vfd, vfd->marquee.bursts[grid]);
+    }
+    if (vfd->clock.scan_mask & (1u << grid)) {
+        return _step_burst(vfd, vfd->clock.bursts[grid]);
+    }
+    if (vfd->posted.scan_mask & (1u << grid)) {
+        return _step_burst(vfd, vfd->posted.bursts[2 * grid]);
+    }
+    return _step_burst(vfd, _scan_source(vfd)->bursts[2 * grid]);
+}
+
+/* The blank burst that ends the lit part of a grid slot */
+static const uint8_t *_blank_burst(vfd_t *vfd, uint8_t grid) {
+    if (vfd->posted.scan_mask & (1u << grid)) {
+        return _step_burst(vfd, vfd->posted.bursts[2 * grid + 1]);
+    }
+    return _step_burst(vfd, _scan_source(vfd)->bursts[2 * grid + 1]);
+}
+
+/* Write the lit word of a front frame grid to the VFD chip
+ * Returns how long the grid should stay lit before its blank word is sent;
+ * a full slot means the blank word can be skipped.
+ */
+static uint32_t _write_vfd_raw(vfd_t *vfd, uint8_t grid, bool first) {
+    if (grid >= vfd->steps) {
+        return 0;
+    }
+
+    _send_and_latch(vfd, _lit_burst(vfd, grid, first));
+    return _scan_source(vfd)->on_us[grid];
+}
+
+/* Write the blank word that ends the lit part of a grid slot */
+static void _write_vfd_blank(vfd_t *vfd, uint8_t grid) {
+    _send_and_latch(vfd, _blank_burst(vfd, grid));
+}
+
+/* Autorefresh timer callback
+ * Runs in IRQ context and steps one grid per slot from the front frame's
+ * cached words. A dimmed grid takes two ticks: the lit word, then the blank
+ * word after on_us, with the alarm period alternated in between so the slot
+ * length stays fixed. Steps the frame does not scan cost no tick at all.
+ * The latest commit is picked up when a frame starts (scan_grid past the
+ * last step), so a frame is never mixed from two commits. A queued control
+ * command takes the place of one grid slot so the ISR stays the only user
+ * of the SPI port while running.
+ */
+static int64_t _autorefresh_alarm(int32_t id, void *user_data) {
+    (void)id;
+    vfd_t *vfd = (vfd_t *)user_data;
+    uint8_t grid = vfd->scan_grid;
+    int64_t next_us = vfd->config.refresh_interval_us;
+
+    if (vfd->scan_blanking) {
+        const vfd_frame_t *frame = _scan_source(vfd);
+        _write_vfd_blank(vfd, grid);
+        vfd->scan_blanking = false;
+        vfd->scan_grid = _next_step(vfd, frame, grid + 1);
+        next_us = _stretch(vfd, frame->slot_us[grid] - frame->on_us[grid]);
+    } else if (vfd->command_pending) {
+        _write_vfd_command(vfd, vfd->pending_command);
+        vfd->command_pending = false;
+    } else {
+        bool first = (grid >= vfd->steps);
+        if (first) {
+            _latch_front(vfd);
+            _marquee_frame(vfd);
+            _clock_frame(vfd);
+            _posted_frame(vfd);
+            if (_idle_frame(vfd, max6921_hal_time_us())) {
+                /* Parked: no alarm until _wake_scan() re-arms one */
+                _write_vfd_command(vfd, 0);
+                vfd->parked = true;
+                return 0;
+            }
+            grid = _first_step(vfd, _scan_source(vfd));
+            vfd->scan_grid = grid;
+        }
+
+        const vfd_frame_t *frame = _scan_source(vfd);
+        uint32_t on_us = _write_vfd_raw(vfd, grid, first);
+        next_us = _stretch(vfd, frame->slot_us[grid]);
+        if (on_us < frame->slot_us[grid]) {
+            vfd->scan_blanking = true;
+            on_us = _stretch(vfd, on_us);
+            next_us = (on_us > 0) ? on_us : 1;
+        } else {
+            vfd->scan_grid = _next_step(vfd, frame, grid + 1);
+        }
+    }
+
+    _stats_tick(vfd, (uint64_t)next_us);
+
+    /* Negative return: next tick is relative to this tick's target time */
+    return -next_us;
+}
+
+#if !MAX6921_HOST
+/* Core 1 waits for a deadline: spinning, or asleep in WFE with low_power */
+static void _core1_wait(vfd_t *vfd, uint64_t deadline) {
+    if (vfd->config.low_power) {
+        max6921_hal_sleep_until(deadline);
+    } else {
+        busy_wait_until(from_us_since_boot(deadline));
+    }
+}
+
+/* Core 1 has nothing to show: sleep until a commit, marquee, clock, animation,
+ * queued command or FIFO message; core 0 sends an event after each */
+static void _core1_park(vfd_t *vfd) {
+    _write_vfd_command(vfd, 0);
+    vfd->parked = true;
+    while (!multicore_fifo_rvalid() && vfd->commit_seq == vfd->seen_seq &&
+           !vfd->marquee.active && !vfd->clock.active && !vfd->player.active &&
+           vfd->update_head == vfd->update_tail &&
+           !(vfd->queued_command & VFD_COMMAND_QUEUED)) {
+        __wfe();
+    }
+    vfd->parked = false;
+}
+
+/* Core 1 refresh service
+ * Owns the SPI port and latch while running. Grid slots, including the
+ * blanking point of dimmed grids, are timed against absolute deadlines with
+ * busy-waits, so nothing core 0 does (interrupts, flash-heavy code, long
+ * critical sections) shifts the scan. With low_power it sleeps in WFE
+ * instead, woken by the SDK's alarm, at the cost of a few us of wake-up
+ * jitter. Control commands arrive over the SIO FIFO and are sent in place
+ * of a grid slot; commits are picked up from the shared ready index at
+ * grid 0.
+ */
+static void _core1_main(void) {
+    vfd_t *vfd = g_vfd_core1_owner;
+    uint32_t slot_us = vfd->config.refresh_interval_us;
+    uint64_t deadline = max6921_hal_time_us();
+    uint8_t grid = VFD_GRIDS_MAX;
+
+    _stats_restart(vfd, deadline);
+
+    while (true) {
+        uint32_t step_us;
+        if (multicore_fifo_rvalid()) {
+            uint32_t msg = multicore_fifo_pop_blocking();
+
+            if ((msg & VFD_CORE1_MSG_TYPE) == VFD_CORE1_MSG_STOP) {
+                _write_vfd_command(vfd, 0);
+                multicore_fifo_push_blocking(VFD_CORE1_MSG_STOP);
+                return;
+            }
+
+            if ((msg & VFD_CORE1_MSG_TYPE) == VFD_CORE1_MSG_COMMAND) {
+                _write_vfd_command(vfd, (uint8_t)(msg & 0x7));
+            }
+            step_us = slot_us;
+        } else {
+            bool first = (grid >= vfd->steps);
+            if (first) {
+                _latch_front(vfd);
+                _marquee_frame(vfd);
+                _clock_frame(vfd);
+                _posted_frame(vfd);
+                if (_idle_frame(vfd, max6921_hal_time_us())) {
+                    _core1_park(vfd);
+                    deadline = max6921_hal_time_us();
+                    _stats_restart(vfd, deadline);
+                    continue;
+                }
+                grid = _first_step(vfd, _scan_source(vfd));
+            }
+            const vfd_frame_t *frame = _scan_source(vfd);
+            uint32_t on_us = _write_vfd_raw(vfd, grid, first);
+            step_us = _stretch(vfd, frame->slot_us[grid]);
+            if (on_us < frame->slot_us[grid]) {
+                on_us = _stretch(vfd, on_us);
+                _stats_deadline(vfd, deadline + on_us);
+                _core1_wait(vfd, deadline + on_us);
+                _write_vfd_blank(vfd, grid);
+            }
+            grid = _next_step(vfd, frame, grid + 1);
+        }
+
+        deadline += step_us;
+        _stats_deadline(vfd, deadline);
+        _core1_wait(vfd, deadline);
+    }
+}
+
+/* Hand the instance to core 1 */
+static vfd_error_t _core1_start(vfd_t *vfd) {
+    multicore_reset_core1();
+    _idle_reset(vfd);
+    vfd->engine = VFD_ENGINE_CORE1;
+    g_vfd_core1_owner = vfd;
+    multicore_launch_core1(_core1_main);
+    return VFD_OK;
+}
+
+/* Queue a message for core 1 without blocking; false if the FIFO is full */
+static bool _core1_post(uint32_t msg) {
+    if (!multicore_fifo_wready()) {
+        return false;
+    }
+    multicore_fifo_push_blocking(msg);
+    return true;
+}
+
+/* Core 1 blanks the tube itself and acknowledges before parking */
+static void _core1_stop(void) {
+    multicore_fifo_push_blocking(VFD_CORE1_MSG_STOP);
+    while (multicore_fifo_pop_blocking() != VFD_CORE1_MSG_STOP) {
+        tight_loop_contents();
+    }
+    multicore_reset_core1();
+    g_vfd_core1_owner = NULL;
+}
+#else
+static vfd_error_t _core1_start(vfd_t *vfd) { (void)vfd; return VFD_ERR_UNSUPPORTED; }
+static bool _core1_post(uint32_t msg) { (void)msg; return false; }
+static void _core1_stop(void) {}
+#endif
+
+/* Restart a parked engine after the display changed
+ * The timer ISR cannot run while parked, as its alarm is gone; core 1 is
+ * in WFE and rechecks its wake conditions on any event.
+ */
+static void _wake_scan(vfd_t *vfd) {
+    __dmb();
+    if (!vfd->parked) {
+        return;
+    }
+
+    if (vfd->engine == VFD_ENGINE_TIMER) {
+        uint64_t first = max6921_hal_time_us() + vfd->config.refresh_interval_us;
+        vfd->scan_grid = VFD_GRIDS_MAX;
+        vfd->scan_blanking = false;
+        _stats_restart(vfd, first);
+        int32_t id = max6921_hal_alarm_at(first, _autorefresh_alarm, vfd);
+        if (id > 0) {
+            vfd->alarm_id = id;
+            vfd->parked = false;
+        }
+    }
+#if !MAX6921_HOST
+    else if (vfd->engine == VFD_ENGINE_CORE1) {
+        __sev();
+    }
+#endif
+}
+
+/* Non-blocking transfers
+ * One burst is on the bus at a time and its completion IRQ only pulses
+ * LOAD. An alarm at each word's deadline starts the next one, so a frame is
+ * timed like the timer engine's, but ends after one pass. async_busy stays
+ * set until the last slot is over, and commits are held back meanwhile as
+ * for a running engine.
+ */
+static void _async_finish(vfd_t *vfd) {
+    vfd_async_callback_t done = vfd->async_done;
+    void *user_data = vfd->async_user;
+    vfd->front = vfd->ready;       /* Whatever was committed meanwhile */
+    __dmb();
+    vfd->async_busy = false;
+    if (done != NULL) {
+        done(vfd, user_data);
+    }
+}
+
+/* DMA completion: the burst has left the pin, latch it */
+static void _async_latch(void *user_data) {
+    vfd_t *vfd = (vfd_t *)user_data;
+    _trace_latch(vfd);
+    _pulse_latch(vfd);
+    vfd->async_shifting = false;
+
+    if (vfd->async_command) {
+        _async_finish(vfd);
+    }
+}
+
+static void _async_send(vfd_t *vfd, const uint8_t *burst) {
+    vfd->async_shifting = true;
+    _trace_burst(vfd, burst);
+    max6921_hal_spi_write_async(vfd->config.spi_index, burst, vfd->burst_bytes, _async_latch, vfd);
+}
+
+/* Alarm delay until an absolute deadline; one already past fires at once */
+static int64_t _async_delay(uint64_t due) {
+    uint64_t now = max6921_hal_time_us();
+    return (due > now) ? (int64_t)(due - now) : 1;
+}
+
+/* Alarm at each word deadline of a non-blocking refresh */
+static int64_t _async_alarm(int32_t id, void *user_data) {
+    (void)id;
+    vfd_t *vfd = (vfd_t *)user_data;
+
+    /* A lit part shorter than a burst: the blank word waits for the bus */
+    if (vfd->async_shifting) {
+        return 1;
+    }
+
+    const vfd_frame_t *frame = _scan_source(vfd);
+    uint8_t grid = vfd->async_grid;
+    if (grid >= vfd->steps) {
+        _stats_frame_done(vfd);
+        _async_finish(vfd);
+        return 0;
+    }
+
+    if (vfd->async_blanking) {
+        _async_send(vfd, _blank_burst(vfd, grid));
+        vfd->async_blanking = false;
+    } else {
+        _async_send(vfd, _lit_burst(vfd, grid, grid == _first_step(vfd, frame)));
+        if (frame->on_us[grid] < frame->slot_us[grid]) {
+            vfd->async_blanking = true;
+            return _async_delay(vfd->async_slot + frame->on_us[grid]);
+        }
+    }
+
+    vfd->async_slot += frame->slot_us[grid];
+    vfd->async_grid = _next_step(vfd, frame, grid + 1);
+    return _async_delay(vfd->async_slot);
+}
+
+/* Claim the HAL's non-blocking writes the first time they are used */
+static vfd_error_t _async_claim(vfd_t *vfd) {
+    if (vfd->config.backend != VFD_BACKEND_SPI) {
+        return VFD_ERR_UNSUPPORTED;
+    }
+    if (vfd->engine != VFD_ENGINE_NONE || vfd->async_busy) {
+        return VFD_ERR_BUSY;
+    }
+    if (!vfd->async_ready) {
+        if (!max6921_hal_spi_async_init(vfd->config.spi_index)) {
+            return VFD_ERR_HARDWARE;
+        }
+        vfd->async_ready = true;
+    }
+    return VFD_OK;
+}
+
+/* Blocking bus users wait for a non-blocking transfer to finish first
+ * Waiting through the HAL lets a simulated clock reach the completion. */
+static void _async_wait(vfd_t *vfd) {
+    __dmb();
+    while (vfd->async_busy) {
+        max6921_hal_busy_wait_us(1);
+    }
+}
+
+/* Initialize GPIO pins */
+static vfd_error_t _init_gpio(vfd_t *vfd, const vfd_config_t *config) {
+    uint32_t actual_baudrate;
+    if (config->latch == VFD_LATCH_SPI_CS) {
+        actual_baudrate = max6921_hal_spi_init_latched(config->spi_index, config->spi_baudrate,
+                                                       config->pin_spi_tx, config->pin_spi_clk,
+                                                       config->pin_latch);
+    } else {
+        actual_baudrate = max6921_hal_spi_init(config->spi_index, config->spi_baudrate,
+                                               config->pin_spi_tx, config->pin_spi_clk);
+    }
+
+    if (actual_baudrate == 0) {
+        return VFD_ERR_HARDWARE;
+    }
+
+    /* A target rate must leave room for the lit and blank burst of a slot */
+    uint32_t burst_us = (vfd->burst_bytes * 8u * 1000000u + actual_baudrate - 1) / actual_baudrate + 1;
+    if (config->target_fps != 0 && config->refresh_interval_us < 2 * burst_us) {
+        max6921_hal_spi_deinit(config->spi_index);
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (config->latch == VFD_LATCH_GPIO) {
+        max6921_hal_gpio_init_output(config->pin_latch);
+        max6921_hal_gpio_put(config->pin_latch, 0);
+    }
+
+    vfd->baudrate = actual_baudrate;
+    return VFD_OK;
+}
+
+/* Patterns tried at each calibration rate: alternating bits, the worst
+ * case for a slow edge, then pseudo-random ones */
+#define VFD_CALIBRATE_PATTERNS 4
+
+/* Send a known burst round the chain and check what DOUT shifts back
+ * The chain delays the stream by 20 bits per chip, so the pattern goes out
+ * twice and the second copy returns rotated by that delay. Zeros follow to
+ * leave the registers blank.
+ */
+static bool _loopback_ok(vfd_t *vfd, uint32_t pattern) {
+    uint8_t tx[3 * VFD_BURST_BYTES_MAX] = {0};
+    uint8_t rx[3 * VFD_BURST_BYTES_MAX];
+    uint32_t len = vfd->burst_bytes;
+    uint32_t bits = len * 8u;
+    uint32_t delay = 20u * vfd->config.chain_length;
+    uint32_t state = pattern;
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t byte = 0xAA;
+        if (pattern != 0) {
+            state ^= state << 13;  /* xorshift32 */
+            state ^= state >> 17;
+            state ^= state << 5;
+            byte = (uint8_t)state;
+        }
+        tx[i] = byte;
+        tx[len + i] = byte;
+        tx[2 * len + i] = 0;
+    }
+
+    max6921_hal_spi_transfer(vfd->config.spi_index, tx, rx, 3 * len);
+
+    for (uint32_t t = 0; t < bits; t++) {
+        uint32_t src = (t + bits - delay) % bits;
+        uint32_t sent = (tx[src / 8] >> (7 - src % 8)) & 1u;
+        uint32_t got = (rx[len + t / 8] >> (7 - t % 8)) & 1u;
+        if (sent != got) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Every calibration pattern reads back at the running rate */
+static bool _loopback_clean(vfd_t *vfd) {
+    for (uint32_t i = 0; i < VFD_CALIBRATE_PATTERNS; i++) {
+        if (!_loopback_ok(vfd, i * 0x9E3779B9u)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if !MAX6921_HOST
+/* Load the scan-out program and claim a state machine on the chosen PIO */
+static vfd_error_t _init_pio(vfd_t *vfd, const vfd_config_t *config) {
+    PIO pio = _pio_block(vfd);
+
+    if (!pio_can_add_program(pio, &MAX6921_PIO_PROGRAM)) {
+        return VFD_ERR_HARDWARE;
+    }
+
+    int sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) {
+        return VFD_ERR_HARDWARE;
+    }
+
+    vfd->pio_sm = (uint)sm;
+    vfd->pio_offset = pio_add_program(pio, &MAX6921_PIO_PROGRAM);
+
+    /* Two PIO cycles per bit; divider kept in 1/256 steps to avoid floats */
+    uint64_t pio_hz = 2ull * config->spi_baudrate;
+    uint64_t div256 = ((uint64_t)clock_get_hz(clk_sys) * 256) / pio_hz;
+    if (div256 < 256) {
+        div256 = 256;
+    }
+    pio_hz = ((uint64_t)clock_get_hz(clk_sys) * 256) / div256;
+    vfd->baudrate = (uint32_t)(pio_hz / 2);
+
+    /* Grid slot = two words of shift/latch overhead + 8 cycles per hold unit,
+     * split between the lit and blank word by brightness */
+    uint64_t slot_cycles = (pio_hz * config->refresh_interval_us) / 1000000u;
+    uint64_t units = 0;
+    if (slot_cycles > 2 * MAX6921_PIO_SHIFT_CYCLES) {
+        units = (slot_cycles - 2 * MAX6921_PIO_SHIFT_CYCLES) / MAX6921_PIO_CYCLES_PER_HOLD;
+    }
+    /* STRETCH can hand one lit step the whole frame's units, and one word
+     * of it up to all but one; that must fit the hold count as well */
+    uint64_t max_units = units;
+    if (config->scan_mode == VFD_SCAN_STRETCH) {
+        max_units = units * vfd->steps - 1;
+    }
+    if (units < 2 || max_units > MAX6921_PIO_HOLD_MAX || div256 > 0xFFFFFF) {
+        pio_remove_program(pio, &MAX6921_PIO_PROGRAM, vfd->pio_offset);
+        pio_sm_unclaim(pio, vfd->pio_sm);
+        return VFD_ERR_INVALID_PARAM;
+    }
+    vfd->pio_hold_units = (uint32_t)units;
+
+    uint offset = vfd->pio_offset;
+    uint sm_index = vfd->pio_sm;
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + MAX6921_PIO_WRAP_TARGET, offset + MAX6921_PIO_WRAP);
+    sm_config_set_sideset(&c, 2, true, false);
+    sm_config_set_out_pins(&c, config->pin_spi_tx, 1);
+    sm_config_set_set_pins(&c, config->pin_latch, 1);
+    sm_config_set_sideset_pins(&c, config->pin_spi_clk);
+    sm_config_set_out_shift(&c, false, false, 32);
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv_int_frac(&c, (uint16_t)(div256 >> 8), (uint8_t)(div256 & 0xFF));
+
+    pio_gpio_init(pio, config->pin_spi_tx);
+    pio_gpio_init(pio, config->pin_spi_clk);
+    pio_gpio_init(pio, config->pin_latch);
+    pio_sm_set_consecutive_pindirs(pio, sm_index, config->pin_spi_tx, 1, true);
+    pio_sm_set_consecutive_pindirs(pio, sm_index, config->pin_spi_clk, 1, true);
+    pio_sm_set_consecutive_pindirs(pio, sm_index, config->pin_latch, 1, true);
+
+    pio_sm_init(pio, sm_index, offset, &c);
+    pio_sm_set_enabled(pio, sm_index, true);
+
+    return VFD_OK;
+}
+
+/* Start the self-restarting DMA pair
+ * The data channel streams the 18-word frame (lit + blank word per grid)
+ * into the TX FIFO, paced by the state machine's DREQ, then chains to the
+ * control channel. The control channel writes dma_frame_addr back into the
+ * data channel's read address trigger, restarting the frame. A plain ring
+ * wrap is not usable because 18 words is not a power-of-two region.
+ */
+static vfd_error_t _start_pio_scan(vfd_t *vfd) {
+    int data_chan = dma_claim_unused_channel(false);
+    int ctrl_chan = dma_claim_unused_channel(false);
+    if (data_chan < 0 || ctrl_chan < 0) {
+        if (data_chan >= 0) {
+            dma_channel_unclaim((uint)data_chan);
+        }
+        if (ctrl_chan >= 0) {
+            dma_channel_unclaim((uint)ctrl_chan);
+        }
+        return VFD_ERR_HARDWARE;
+    }
+
+    vfd->dma_data_chan = data_chan;
+    vfd->dma_ctrl_chan = ctrl_chan;
+    vfd->dma_frame_addr = _dma_source(vfd);
+
+    dma_channel_config dc = dma_channel_get_default_config((uint)data_chan);
+    channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+    channel_config_set_read_increment(&dc, true);
+    channel_config_set_write_increment(&dc, false);
+    channel_config_set_dreq(&dc, pio_get_dreq(_pio_block(vfd), vfd->pio_sm, true));
+    channel_config_set_chain_to(&dc, (uint)ctrl_chan);
+    dma_channel_configure((uint)data_chan, &dc,
+                          &_pio_block(vfd)->txf[vfd->pio_sm],
+                          vfd->dma_frame_addr,
+                          2u * vfd->steps, false);
+
+    dma_channel_config cc = dma_channel_get_default_config((uint)ctrl_chan);
+    channel_config_set_transfer_data_size(&cc, DMA_SIZE_32);
+    channel_config_set_read_increment(&cc, false);
+    channel_config_set_write_increment(&cc, false);
+    dma_channel_configure((uint)ctrl_chan, &cc,
+                          &dma_hw->ch[data_chan].al3_read_addr_trig,
+                          &vfd->dma_frame_addr, 1, true);
+
+    return VFD_OK;
+}
+
+/* Break the DMA chain, release both channels and blank the tube */
+static void _stop_pio_scan(vfd_t *vfd) {
+    uint data_chan = (uint)vfd->dma_data_chan;
+    uint ctrl_chan = (uint)vfd->dma_ctrl_chan;
+
+    /* Point the data channel's chain at itself so the abort cannot re-arm it */
+    dma_channel_config dc = dma_get_channel_config(data_chan);
+    channel_config_set_chain_to(&dc, data_chan);
+    dma_channel_set_config(data_chan, &dc, false);
+
+    dma_channel_abort(ctrl_chan);
+    dma_channel_abort(data_chan);
+    dma_channel_unclaim(ctrl_chan);
+    dma_channel_unclaim(data_chan);
+    vfd->dma_data_chan = -1;
+    vfd->dma_ctrl_chan = -1;
+
+    /* Drop queued grid words and restart the program before blanking */
+    PIO pio = _pio_block(vfd);
+    uint sm = vfd->pio_sm;
+    pio_sm_set_enabled(pio, sm, false);
+    pio_sm_clear_fifos(pio, sm);
+    pio_sm_restart(pio, sm);
+    pio_sm_exec(pio, sm, pio_encode_jmp(vfd->pio_offset));
+    pio_sm_set_enabled(pio, sm, true);
+    pio_sm_put_blocking(pio, sm, 0);
+}
+
+/* Release the state machine and program */
+static void _deinit_pio(vfd_t *vfd) {
+    pio_sm_set_enabled(_pio_block(vfd), vfd->pio_sm, false);
+    pio_remove_program(_pio_block(vfd), &MAX6921_PIO_PROGRAM, vfd->pio_offset);
+    pio_sm_unclaim(_pio_block(vfd), vfd->pio_sm);
+}
+
+/* Queue one self-timed word on the state machine */
+static void _pio_put(vfd_t *vfd, uint32_t word) {
+    pio_sm_put_blocking(_pio_block(vfd), vfd->pio_sm, word);
+}
+#else
+/* No PIO on the host; init refuses the backend so the rest never runs */
+static vfd_error_t _init_pio(vfd_t *vfd, const vfd_config_t *config) {
+    (void)vfd;
+    (void)config;
+    return VFD_ERR_UNSUPPORTED;
+}
+static vfd_error_t _start_pio_scan(vfd_t *vfd) { (void)vfd; return VFD_ERR_UNSUPPORTED; }
+static void _stop_pio_scan(vfd_t *vfd) { (void)vfd; }
+static void _deinit_pio(vfd_t *vfd) { (void)vfd; }
+static void _pio_put(vfd_t *vfd, uint32_t word) { (void)vfd; (void)word; }
+#endif
+
+/* Public API */
+
+vfd_config_t vfd_default_config(void) {
+    vfd_config_t config = {
+        .spi_baudrate = 2000000,
+        .pin_spi_tx = 11,
+        .pin_spi_clk = 10,
+        .pin_latch = 13,
+        .refresh_interval_us = 1500,
+        .backend = VFD_BACKEND_SPI,
+        .pio_index = 0,
+        .spi_index = 1,
+        .chain_length = 1,
+        .scan_mode = VFD_SCAN_FULL,
+        .target_fps = 0,
+        .low_power = false,
+        .idle_fps = 0,
+        .idle_after_ms = 1000,
+        .latch = VFD_LATCH_GPIO,
+        .pin_spi_rx = 12,
+        .grids = 9,
+        .output_map = NULL,
+        .boot_frame = NULL
+    };
+    return config;
+}
+
+vfd_output_map_t vfd_default_output_map(uint8_t grids) {
+    vfd_output_map_t map;
+    memset(&map, VFD_OUTPUT_NONE, sizeof(map));
+
+    /* IV-18 board: grid 0 on OUT16 down to grid 8 on OUT8; larger tubes
+     * take the command outputs from OUT17 up */
+    for (uint8_t step = 0; step < grids && step < VFD_GRIDS_MAX; step++) {
+        map.grid[step] = (step < 9) ? (uint8_t)(16 - step) : (uint8_t)(8 + step);
+    }
+    for (uint8_t segment = 0; segment < 8; segment++) {
+        map.segment[segment] = segment;
+    }
+    for (uint8_t bit = 0; bit < 3; bit++) {
+        if (grids <= 9 + bit) {
+            map.command[bit] = (uint8_t)(17 + bit);
+        }
+    }
+    return map;
+}
+
+vfd_error_t vfd_init_ex(vfd_t *vfd, const vfd_config_t *config) {
+    if (vfd == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (vfd->initialized) {
+        return VFD_OK;
+    }
+
+    if (config == NULL) {
+        vfd->config = vfd_default_config();
+    } else {
+        if (config->spi_baudrate == 0 || config->refresh_interval_us == 0) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        if (config->backend > VFD_BACKEND_PIO || config->pio_index > 1 ||
+            config->spi_index > 1) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        /* The PIO program latches after every 20 bits, so it drives one chip */
+        if (config->chain_length < 1 || config->chain_length > VFD_CHAIN_MAX ||
+            (config->backend == VFD_BACKEND_PIO && config->chain_length > 1)) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        if (config->scan_mode > VFD_SCAN_STRETCH) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        if (config->grids < 1 || config->grids > VFD_GRIDS_MAX) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        /* CSn is only on every fourth GPIO, and its SPI block alternates
+         * in banks of eight (1, 5: spi0; 9, 13: spi1; ...) */
+        if (config->latch > VFD_LATCH_SPI_CS ||
+            (config->latch == VFD_LATCH_SPI_CS &&
+             (config->backend != VFD_BACKEND_SPI || config->pin_latch % 4 != 1 ||
+              ((config->pin_latch / 8) & 1) != config->spi_index))) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        /* The shortening modes change the frame rate on purpose */
+        if (config->target_fps != 0 &&
+            (config->scan_mode == VFD_SCAN_SHORTEN ||
+             config->scan_mode == VFD_SCAN_SHORTEN_CONSTANT)) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        vfd->config = *config;
+    }
+
+    vfd->steps = vfd->config.grids;
+    vfd->all_steps = (uint16_t)((1u << vfd->steps) - 1);
+    vfd_output_map_t map = (vfd->config.output_map != NULL)
+                               ? *vfd->config.output_map
+                               : vfd_default_output_map(vfd->steps);
+    if (!_build_output_map(vfd, &map)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    vfd->grid_count = (uint8_t)(vfd->steps * vfd->config.chain_length);
+    for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+        vfd->grid_slot[grid] = (uint8_t)(((grid / vfd->steps) << 4) | (grid % vfd->steps));
+    }
+    /* CSn framing shifts whole 16-bit frames; the padding leads the burst
+     * and falls off the end of the chain */
+    if (vfd->config.latch == VFD_LATCH_SPI_CS) {
+        vfd->burst_bytes = (uint8_t)((20 * vfd->config.chain_length + 15) / 16 * 2);
+    } else {
+        vfd->burst_bytes = (uint8_t)((20 * vfd->config.chain_length + 7) / 8);
+    }
+
+    /* A target rate replaces the slot length; the remainder of 1 s / fps is
+     * spread over the steps so the frame period is exact to the us */
+    if (vfd->config.target_fps != 0) {
+        vfd->frame_us = (1000000u + vfd->config.target_fps / 2) / vfd->config.target_fps;
+        /* Too slow a rate for this few grids leaves a slot that does not
+         * fit refresh_interval_us */
+        if (vfd->frame_us / vfd->steps > UINT16_MAX) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+        vfd->config.refresh_interval_us = (uint16_t)(vfd->frame_us / vfd->steps);
+    } else {
+        vfd->frame_us = (uint32_t)vfd->steps * vfd->config.refresh_interval_us;
+    }
+    if (vfd->config.idle_fps != 0) {
+        vfd->idle_frame_us = (1000000u + vfd->config.idle_fps / 2) / vfd->config.idle_fps;
+    } else {
+        vfd->idle_frame_us = 0;
+    }
+    vfd->commit_seq = 0;
+    _idle_reset(vfd);
+    vfd->engine = VFD_ENGINE_NONE;
+    vfd->queued_command = 0;
+    vfd->step_command = 0;
+    vfd->async_busy = false;
+    vfd->async_shifting = false;
+    vfd->async_ready = false;
+    vfd->update_head = 0;
+    vfd->update_tail = 0;
+    vfd->update_overflows = 0;
+    memset(&vfd->posted, 0, sizeof(vfd->posted));
+    vfd->dma_data_chan = -1;
+    vfd->dma_ctrl_chan = -1;
+    memset(&vfd->marquee, 0, sizeof(vfd->marquee));
+    memset(&vfd->clock, 0, sizeof(vfd->clock));
+    vfd->clock.next_tick = max6921_hal_time_us() + 1000000u;
+    memset(&vfd->player, 0, sizeof(vfd->player));
+    vfd->player.ready_stage = -1;
+    vfd->player.scan_stage = -1;
+    _stats_init(vfd);
+    _trace_init(vfd);
+
+    vfd_error_t err;
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        err = _init_pio(vfd, &vfd->config);
+    } else {
+        err = _init_gpio(vfd, &vfd->config);
+    }
+    if (err != VFD_OK) {
+        return err;
+    }
+
+    /* The registers power up holding whatever they shifted in; blank them
+     * before anything else so the tube never shows that */
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        _pio_put(vfd, 0);
+    } else {
+        _write_vfd_command(vfd, 0);
+    }
+
+    /* Start from three identical blank frames at full brightness */
+    vfd->back = 0;
+    vfd->ready = 0;
+    vfd->front = 0;
+    for (uint8_t i = 0; i < VFD_FRAME_COUNT; i++) {
+        vfd->stale[i] = vfd->all_steps;
+    }
+    memset(vfd->frames[0].levels, VFD_BRIGHTNESS_MAX, sizeof(vfd->frames[0].levels));
+    memset(vfd->frames[0].commands, 0, sizeof(vfd->frames[0].commands));
+    _clear(vfd);
+    if (vfd->config.boot_frame != NULL) {
+        for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+            _set_grid(vfd, grid, vfd->config.boot_frame[grid]);
+        }
+    }
+    vfd->dirty = vfd->all_steps;
+    _commit_frame(vfd);
+
+    vfd->initialized = true;
+
+    /* A boot frame is on the tube from the engine's first slot, before the
+     * application has done anything */
+    if (vfd->config.boot_frame != NULL) {
+        err = vfd_start_autorefresh_ex(vfd);
+        if (err != VFD_OK) {
+            vfd_deinit_ex(vfd);
+            return err;
+        }
+    }
+    return VFD_OK;
+}
+
+bool vfd_is_initialized_ex(vfd_t *vfd) {
+    return vfd != NULL && vfd->initialized;
+}
+
+vfd_error_t vfd_deinit_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _player_stop(vfd);
+    vfd_stop_autorefresh_ex(vfd);
+    _marquee_quiesce(vfd);
+    _clock_stop(vfd);
+
+    _clear(vfd);
+    vfd_refresh_ex(vfd);
+
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        _deinit_pio(vfd);
+    } else {
+        if (vfd->async_ready) {
+            max6921_hal_spi_async_deinit(vfd->config.spi_index);
+            vfd->async_ready = false;
+        }
+        max6921_hal_spi_deinit(vfd->config.spi_index);
+    }
+
+    vfd->buffer_shared = false;
+    vfd->initialized = false;
+    return VFD_OK;
+}
+
+vfd_error_t vfd_calibrate_baudrate_ex(vfd_t *vfd, uint32_t max_baudrate) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+    if (vfd->config.backend != VFD_BACKEND_SPI) {
+        return VFD_ERR_UNSUPPORTED;
+    }
+    if (max_baudrate < vfd->config.spi_baudrate) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+    if (vfd->engine != VFD_ENGINE_NONE || vfd->async_busy) {
+        return VFD_ERR_BUSY;
+    }
+
+    uint8_t spi = vfd->config.spi_index;
+    max6921_hal_spi_init_rx(spi, vfd->config.pin_spi_rx);
+
+    /* Climb until a rate fails; the divider may map several onto one */
+    uint32_t floor = 0;
+    uint32_t best = 0;
+    uint32_t rate = vfd->config.spi_baudrate;
+    while (true) {
+        uint32_t actual = max6921_hal_spi_set_baudrate(spi, rate);
+        if (actual > best) {
+            if (!_loopback_clean(vfd)) {
+                break;
+            }
+            best = actual;
+            if (floor == 0) {
+                floor = actual;
+            }
+        }
+        if (rate >= max_baudrate) {
+            break;
+        }
+        rate = (rate + rate / 4 + 1 < max_baudrate) ? rate + rate / 4 + 1 : max_baudrate;
+    }
+
+    if (best == 0) {
+        max6921_hal_spi_set_baudrate(spi, vfd->baudrate);
+        return VFD_ERR_HARDWARE;
+    }
+
+    /* Run with margin below the edge, and confirm the rate actually set */
+    rate = best - best / 4;
+    uint32_t actual = max6921_hal_spi_set_baudrate(spi, (rate > floor) ? rate : floor);
+    if (!_loopback_clean(vfd)) {
+        actual = max6921_hal_spi_set_baudrate(spi, floor);
+    }
+    vfd->baudrate = actual;
+    return VFD_OK;
+}
+
+uint32_t vfd_get_baudrate_ex(vfd_t *vfd) {
+    return (vfd != NULL && vfd->initialized) ? vfd->baudrate : 0;
+}
+
+vfd_error_t vfd_write_segments_ex(vfd_t *vfd, uint8_t grid, uint8_t segments) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_grid(vfd, grid)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (!_is_valid_segment(segments)) {
+        return VFD_ERR_INVALID_SEGMENT;
+    }
+
+    _set_grid(vfd, grid, segments);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_read_segments_ex(vfd_t *vfd, uint8_t grid, uint8_t *segments) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_grid(vfd, grid)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (segments == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    *segments = _get_grid(vfd, grid);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_write_digit_ex(vfd_t *vfd, uint8_t grid, uint8_t digit) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_grid(vfd, grid)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (digit > 9) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    _set_grid(vfd, grid, DIGIT_PATTERNS[digit]);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_clear_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _clear(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_refresh_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _commit_frame(vfd);
+
+    /* The background engine picks the commit up at its next frame boundary */
+    if (vfd->engine != VFD_ENGINE_NONE) {
+        _wake_scan(vfd);
+        return VFD_OK;
+    }
+
+    _async_wait(vfd);
+
+    _latch_front(vfd);
+
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        /* The state machine self-times each word; just queue them. A
+         * queued command goes out with grid 0's words. */
+        const vfd_frame_t *frame = _scan_source(vfd);
+        uint32_t command = 0;
+        uint8_t queued = vfd->queued_command;
+        if (queued & VFD_COMMAND_QUEUED) {
+            vfd->queued_command = 0;
+            command = _pack_word(vfd->command_bits[queued & 0x7], 1);
+        }
+        for (uint8_t i = 0; i < 2 * vfd->steps; i++) {
+            _pio_put(vfd, frame->words[i] | ((i < 2) ? command : 0));
+        }
+        return VFD_OK;
+    }
+
+    _marquee_frame(vfd);
+    _clock_frame(vfd);
+    _posted_frame(vfd);
+
+    /* Slots run on absolute deadlines, so transfer time does not add up;
+     * dimmed grids split their slot rather than lengthening it */
+    const vfd_frame_t *frame = _scan_source(vfd);
+    uint64_t deadline = max6921_hal_time_us();
+    bool first = true;
+    for (uint8_t grid = _first_step(vfd, frame); grid < vfd->steps;
+         grid = _next_step(vfd, frame, grid + 1)) {
+        uint32_t on_us = _write_vfd_raw(vfd, grid, first);
+        first = false;
+        if (on_us < frame->slot_us[grid]) {
+            max6921_hal_sleep_until(deadline + on_us);
+            _write_vfd_blank(vfd, grid);
+        }
+        deadline += frame->slot_us[grid];
+        max6921_hal_sleep_until(deadline);
+    }
+    _stats_frame_done(vfd);
+
+    return VFD_OK;
+}
+
+vfd_error_t vfd_refresh_async_ex(vfd_t *vfd, vfd_async_callback_t on_done, void *user_data) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    vfd_error_t err = _async_claim(vfd);
+    if (err != VFD_OK) {
+        return err;
+    }
+
+    _commit_frame(vfd);
+    _latch_front(vfd);
+    _marquee_frame(vfd);
+    _clock_frame(vfd);
+    _posted_frame(vfd);
+
+    vfd->async_command = false;
+    vfd->async_blanking = false;
+    vfd->async_grid = _first_step(vfd, _scan_source(vfd));
+    vfd->async_slot = max6921_hal_time_us();
+    vfd->async_done = on_done;
+    vfd->async_user = user_data;
+    vfd->async_busy = true;
+
+    /* The first word goes out from the alarm, in IRQ context like the rest */
+    if (max6921_hal_alarm_at(vfd->async_slot, _async_alarm, vfd) <= 0) {
+        vfd->async_busy = false;
+        return VFD_ERR_HARDWARE;
+    }
+    return VFD_OK;
+}
+
+bool vfd_is_async_busy_ex(vfd_t *vfd) {
+    return vfd != NULL && vfd->async_busy;
+}
+
+vfd_error_t vfd_commit_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _commit_frame(vfd);
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_set_brightness_ex(vfd_t *vfd, uint8_t level) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (level > VFD_BRIGHTNESS_MAX) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    memset(vfd->frames[vfd->back].levels, level, vfd->steps);
+    vfd->dirty = vfd->all_steps;
+    return VFD_OK;
+}
+
+vfd_error_t vfd_set_grid_brightness_ex(vfd_t *vfd, uint8_t grid, uint8_t level) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_grid(vfd, grid)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (level > VFD_BRIGHTNESS_MAX) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    uint8_t step = vfd->grid_slot[grid] & 0x0F;
+    vfd->frames[vfd->back].levels[step] = level;
+    vfd->dirty |= (uint16_t)(1u << step);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_write_string_ex(vfd_t *vfd, const char *str) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (str == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    _render_text(vfd, 0, vfd->grid_count, str);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_write_region_ex(vfd_t *vfd, uint8_t first_grid, uint8_t count,
+                                const uint8_t *patterns) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_range(vfd, first_grid, count)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (patterns == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        _set_grid(vfd, first_grid + i, patterns[i]);
+    }
+    return VFD_OK;
+}
+
+vfd_error_t vfd_write_string_at_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width,
+                                   const char *str) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_range(vfd, first_grid, width)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (str == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    _render_text(vfd, first_grid, width, str);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_post_update_ex(vfd_t *vfd, const vfd_update_t *update) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (update == NULL || update->kind > VFD_UPDATE_COMMAND || update->mask > vfd->all_steps ||
+        (update->kind == VFD_UPDATE_COMMAND && !_is_valid_command(vfd, update->data[0]))) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (update->chip >= vfd->config.chain_length) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    /* Constant time: one bounds check, one record copy, one index store */
+    uint16_t head = vfd->update_head;
+    if ((uint16_t)(head - vfd->update_tail) >= VFD_UPDATE_QUEUE_SIZE) {
+        vfd->update_overflows++;
+        return VFD_ERR_BUSY;
+    }
+
+    vfd->updates[head % VFD_UPDATE_QUEUE_SIZE] = *update;
+    __dmb();
+    vfd->update_head = head + 1;
+
+    /* A parked core 1 checks the ring when woken; the timer engine, whose
+     * restart is not safe from an interrupt, resumes at the next commit */
+#if !MAX6921_HOST
+    if (vfd->engine == VFD_ENGINE_CORE1 && vfd->parked) {
+        __sev();
+    }
+#endif
+    return VFD_OK;
+}
+
+uint32_t vfd_get_update_overflows_ex(vfd_t *vfd) {
+    return (vfd != NULL) ? vfd->update_overflows : 0;
+}
+
+/* Render a number into a field of the back buffer
+ * Digits are generated least significant first with one divide per digit,
+ * which the SDK maps onto the SIO hardware divider, then laid out by
+ * align. A value that does not fit fills the field with dashes.
+ */
+static vfd_error_t _write_number(vfd_t *vfd, uint8_t first, uint8_t width, uint32_t magnitude,
+                                 bool negative, uint32_t base, uint8_t decimals,
+                                 vfd_align_t align) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_range(vfd, first, width)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (align > VFD_ALIGN_ZERO_PAD || decimals >= width) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    static const char DIGITS[] = "0123456789ABCDEF";
+    uint8_t glyphs[VFD_GRIDS_MAX * VFD_CHAIN_MAX];
+    uint8_t count = 0;
+    do {
+        uint32_t quotient = magnitude / base;
+        glyphs[count++] = ASCII_FONT[(uint8_t)DIGITS[magnitude - quotient * base]];
+        magnitude = quotient;
+    } while ((magnitude != 0 || count <= decimals) && count < width);
+
+    if (magnitude != 0 || count + (negative ? 1 : 0) > width) {
+        for (uint8_t i = 0; i < width; i++) {
+            _set_grid(vfd, first + i, VFD_SYMBOL_DASH);
+        }
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (decimals > 0) {
+        glyphs[decimals] |= VFD_SYMBOL_DOT;
+    }
+
+    uint8_t pad = width - count - (negative ? 1 : 0);
+    uint8_t grid = first;
+
+    if (align == VFD_ALIGN_RIGHT) {
+        for (; pad > 0; pad--) {
+            _set_grid(vfd, grid++, VFD_BLANK);
+        }
+    }
+    if (negative) {
+        _set_grid(vfd, grid++, VFD_SYMBOL_DASH);
+    }
+    if (align == VFD_ALIGN_ZERO_PAD) {
+        for (; pad > 0; pad--) {
+            _set_grid(vfd, grid++, VFD_DIGIT_0);
+        }
+    }
+    while (count > 0) {
+        _set_grid(vfd, grid++, glyphs[--count]);
+    }
+    for (; pad > 0; pad--) {
+        _set_grid(vfd, grid++, VFD_BLANK);
+    }
+
+    return VFD_OK;
+}
+
+vfd_error_t vfd_write_int_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, int32_t value,
+                             vfd_align_t align) {
+    return vfd_write_fixed_ex(vfd, first_grid, width, value, 0, align);
+}
+
+vfd_error_t vfd_write_fixed_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, int32_t value,
+                               uint8_t decimals, vfd_align_t align) {
+    /* Negate in unsigned arithmetic so INT32_MIN is representable */
+    uint32_t magnitude = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    return _write_number(vfd, first_grid, width, magnitude, value < 0, 10, decimals, align);
+}
+
+vfd_error_t vfd_write_hex_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, uint32_t value,
+                             vfd_align_t align) {
+    return _write_number(vfd, first_grid, width, value, false, 16, 0, align);
+}
+
+vfd_error_t vfd_marquee_start_ex(vfd_t *vfd, const vfd_marquee_config_t *config,
+                                 const char *text) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (config == NULL || config->strip == NULL || config->step_us == 0 ||
+        config->direction > VFD_SCROLL_RIGHT) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (!_is_valid_range(vfd, config->first_grid, config->width)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (config->loop ? text == NULL : config->direction != VFD_SCROLL_LEFT) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    /* Every run starts with a blank window's worth of gap */
+    uint32_t count = (text != NULL) ? _strip_count(text, false) : 0;
+    if (config->width + count > config->strip_size) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    /* DMA streams PIO frames with no CPU to draw the window */
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        return VFD_ERR_UNSUPPORTED;
+    }
+
+    uint16_t steps = _window_steps(vfd, config->first_grid, config->width);
+    if (vfd->clock.active && (vfd->clock.steps & steps)) {
+        return VFD_ERR_BUSY;
+    }
+
+    _marquee_quiesce(vfd);
+
+    vfd_marquee_state_t *mq = &vfd->marquee;
+    mq->loop = config->loop;
+    mq->direction = config->direction;
+    mq->first_grid = config->first_grid;
+    mq->width = config->width;
+    mq->strip = config->strip;
+    mq->length = config->strip_size;
+    mq->step_us = config->step_us;
+    mq->head = 0;
+    mq->pos = 0;
+    mq->can_fold = false;
+
+    _strip_blank(mq, config->width);
+    if (text != NULL) {
+        _strip_render(mq, text);
+        mq->head += count;
+    }
+    if (mq->loop) {
+        mq->length = mq->head;
+    }
+
+    mq->steps = steps;
+
+    mq->next_step = max6921_hal_time_us() + config->step_us;
+    mq->gen++;
+    __dmb();
+    mq->active = true;
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_marquee_append_ex(vfd_t *vfd, const char *text) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    vfd_marquee_state_t *mq = &vfd->marquee;
+    if (text == NULL || !mq->active || mq->loop) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    /* Glyphs from pos on may still be shown; only the rest can be reused */
+    uint32_t count = _strip_count(text, mq->can_fold);
+    if (mq->head + count - mq->pos > mq->length) {
+        return VFD_ERR_BUSY;
+    }
+
+    _strip_render(mq, text);
+    __dmb();
+    mq->head += count;
+    mq->gen++;
+    return VFD_OK;
+}
+
+vfd_error_t vfd_marquee_stop_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _marquee_quiesce(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_clock_start_ex(vfd_t *vfd, const vfd_clock_config_t *config) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (config == NULL || config->layout > VFD_CLOCK_HH_MM_SS_DOTS ||
+        config->source > VFD_CLOCK_PPS) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    uint8_t width = CLOCK_WIDTHS[config->layout];
+    if (!_is_valid_range(vfd, config->first_grid, width)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    /* Like the marquee, the face is drawn by the CPU scanner */
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        return VFD_ERR_UNSUPPORTED;
+    }
+
+    uint16_t steps = _window_steps(vfd, config->first_grid, width);
+    if (vfd->marquee.active && (vfd->marquee.steps & steps)) {
+        return VFD_ERR_BUSY;
+    }
+
+    _clock_stop(vfd);
+
+    vfd_clock_state_t *ck = &vfd->clock;
+    ck->source = config->source;
+    ck->layout = config->layout;
+    ck->hour12 = config->hour12;
+    ck->first_grid = config->first_grid;
+    ck->width = width;
+    ck->pin_pps = config->pin_pps;
+    ck->steps = steps;
+    ck->rendered_frame = NULL;
+    ck->redraw = true;
+
+    vfd_error_t err = _clock_claim(vfd);
+    if (err == VFD_OK && ck->source == VFD_CLOCK_RTC && ck->time_pending) {
+        err = _clock_set_rtc(vfd, (uint8_t)(ck->base_time / 3600u),
+                             (uint8_t)(ck->base_time / 60u % 60u), (uint8_t)(ck->base_time % 60u));
+        if (err != VFD_OK) {
+            _clock_release(vfd);
+        }
+    }
+    if (err != VFD_OK) {
+        return err;
+    }
+    ck->time_pending = false;
+
+    __dmb();
+    ck->active = true;
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_clock_set_time_ex(vfd_t *vfd, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (hours > 23 || minutes > 59 || seconds > 59) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    vfd_clock_state_t *ck = &vfd->clock;
+    bool active = ck->active;
+    _clock_quiesce(vfd);
+
+    vfd_error_t err = VFD_OK;
+    if (active && ck->source == VFD_CLOCK_RTC) {
+        err = _clock_set_rtc(vfd, hours, minutes, seconds);
+    } else {
+        /* A PPS edge after this read counts from the new time */
+        ck->base_ticks = ck->ticks;
+        ck->base_time = (uint32_t)hours * 3600u + (uint32_t)minutes * 60u + seconds;
+        ck->time_pending = !active;
+        ck->next_tick = max6921_hal_time_us() + 1000000u;
+    }
+    ck->redraw = true;
+
+    __dmb();
+    ck->active = active;
+    return err;
+}
+
+vfd_error_t vfd_clock_stop_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _clock_stop(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_play_animation_ex(vfd_t *vfd, const vfd_animation_t *animation,
+                                  vfd_anim_callback_t on_done, void *user_data) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (animation == NULL || animation->frames == NULL || animation->frame_count == 0) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    for (uint16_t i = 0; i < animation->frame_count; i++) {
+        if (animation->frames[i].hold_ms == 0) {
+            return VFD_ERR_INVALID_PARAM;
+        }
+    }
+
+    _player_stop(vfd);
+
+    vfd_player_state_t *pl = &vfd->player;
+    pl->animation = animation;
+    pl->index = 0;
+    pl->on_done = on_done;
+    pl->user_data = user_data;
+    pl->active = true;
+
+    /* The first frame is encoded right away, in the alarm's context */
+    int32_t id = max6921_hal_alarm_at(max6921_hal_time_us(), _player_alarm, vfd);
+    if (id <= 0) {
+        _player_release(vfd);
+        return VFD_ERR_HARDWARE;
+    }
+    pl->alarm_id = id;
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_stop_animation_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    _player_stop(vfd);
+    return VFD_OK;
+}
+
+bool vfd_is_animation_playing_ex(vfd_t *vfd) {
+    return vfd != NULL && vfd->player.active;
+}
+
+vfd_error_t vfd_transition_ex(vfd_t *vfd, vfd_transition_t type, uint32_t duration_ms) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (type > VFD_TRANSITION_WIPE) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (type == VFD_TRANSITION_CUT || duration_ms == 0) {
+        return vfd_commit_ex(vfd);
+    }
+
+    _player_stop(vfd);
+
+    vfd_player_state_t *pl = &vfd->player;
+    const vfd_frame_t *from = &vfd->frames[vfd->ready];
+    memcpy(pl->from, from->segments, sizeof(pl->from));
+    memcpy(pl->from_levels, from->levels, sizeof(pl->from_levels));
+    pl->animation = NULL;
+    pl->transition = type;
+    pl->stage_count = _transition_stages(vfd, type, duration_ms);
+    pl->hold_us = (uint32_t)(((uint64_t)duration_ms * 1000u) / pl->stage_count);
+    pl->index = 0;
+    pl->on_done = NULL;
+    pl->active = true;
+
+    /* Stage 0 holds the old frame up before the commit can show */
+    uint32_t seq = vfd->commit_seq;
+    _player_alarm(0, vfd);
+    _commit_frame(vfd);
+    if (vfd->commit_seq == seq) {
+        _player_release(vfd);
+        return VFD_OK;
+    }
+
+    int32_t id = max6921_hal_alarm_at(max6921_hal_time_us() + pl->hold_us, _player_alarm, vfd);
+    if (id <= 0) {
+        _player_release(vfd);
+        _wake_scan(vfd);
+        return VFD_ERR_HARDWARE;
+    }
+    pl->alarm_id = id;
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_set_grid_command_ex(vfd_t *vfd, uint8_t grid, uint8_t command) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_grid(vfd, grid)) {
+        return VFD_ERR_INVALID_GRID;
+    }
+
+    if (!_is_valid_command(vfd, command)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    _set_command(vfd, grid, command);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_set_command_ex(vfd_t *vfd, uint8_t command) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_command(vfd, command)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+        _set_command(vfd, grid, command);
+    }
+    return VFD_OK;
+}
+
+vfd_error_t vfd_queue_command_ex(vfd_t *vfd, uint8_t command) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (!_is_valid_command(vfd, command)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    /* One slot, emptied by the scanner; DMA has no step to put it on */
+    if (vfd->engine == VFD_ENGINE_DMA || (vfd->queued_command & VFD_COMMAND_QUEUED)) {
+        return VFD_ERR_BUSY;
+    }
+
+    vfd->queued_command = VFD_COMMAND_QUEUED | command;
+    _wake_scan(vfd);
+    return VFD_OK;
+}
+
+vfd_display_buffer_t *vfd_get_buffer_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return NULL;
+    }
+    /* Direct edits bypass the dirty mask; re-encode everything on commit */
+    vfd->buffer_shared = true;
+    return &vfd->frames[vfd->back].segments[0];
+}
+
+vfd_error_t vfd_fill_buffer_ex(vfd_t *vfd, uint8_t segments) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    for (uint8_t grid = 0; grid < vfd->grid_count; grid++) {
+        _set_grid(vfd, grid, segments);
+    }
+    return VFD_OK;
+}
+
+vfd_error_t vfd_send_control_command_ex(vfd_t *vfd, const vfd_control_command_t *cmd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (cmd == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    if (!_is_valid_command(vfd, cmd->command)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    /* Put the command's bits on the outputs the map assigns them
+     * (command_bits[]) and send it with no grid or segment lit. User can
+     * define what each command code (0-7) does in their application.
+     * Every chip in the cascade gets the same word, in one burst_bytes
+     * burst with the padding leading (whole 16-bit frames with CSn).
+     * The timer ISR and core 1 send it in place of their next grid step.
+     * The PIO backend sends the same word through the state machine, which
+     * is only possible while DMA is not streaming frames into it.
+     */
+    switch (vfd->engine) {
+    case VFD_ENGINE_DMA:
+        return VFD_ERR_BUSY;
+
+    case VFD_ENGINE_TIMER:
+        if (vfd->command_pending) {
+            return VFD_ERR_BUSY;
+        }
+        vfd->pending_command = cmd->command;
+        vfd->command_pending = true;
+        _wake_scan(vfd);
+        return VFD_OK;
+
+    case VFD_ENGINE_CORE1:
+        if (!_core1_post(VFD_CORE1_MSG_COMMAND | cmd->command)) {
+            return VFD_ERR_BUSY;
+        }
+        return VFD_OK;
+
+    default:
+        break;
+    }
+
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        _pio_put(vfd, _pack_word(vfd->command_bits[cmd->command], 1));
+        return VFD_OK;
+    }
+
+    _async_wait(vfd);
+    _write_vfd_command(vfd, cmd->command);
+
+    return VFD_OK;
+}
+
+vfd_error_t vfd_send_control_command_async_ex(vfd_t *vfd, const vfd_control_command_t *cmd,
+                                              vfd_async_callback_t on_done, void *user_data) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (cmd == NULL || !_is_valid_command(vfd, cmd->command)) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    vfd_error_t err = _async_claim(vfd);
+    if (err != VFD_OK) {
+        return err;
+    }
+
+    uint32_t words[VFD_CHAIN_MAX];
+    for (uint8_t chip = 0; chip < VFD_CHAIN_MAX; chip++) {
+        words[chip] = vfd->command_bits[cmd->command];
+    }
+    _pack_burst(vfd, vfd->async_burst, words);
+
+    vfd->async_command = true;
+    vfd->async_done = on_done;
+    vfd->async_user = user_data;
+    vfd->async_busy = true;
+    _trace_command(vfd, cmd->command);
+    _async_send(vfd, vfd->async_burst);
+    return VFD_OK;
+}
+
+vfd_error_t vfd_start_autorefresh_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (vfd->engine != VFD_ENGINE_NONE) {
+        return VFD_OK;
+    }
+
+    _async_wait(vfd);
+
+    if (vfd->config.backend == VFD_BACKEND_PIO) {
+        vfd_error_t err = _start_pio_scan(vfd);
+        if (err != VFD_OK) {
+            return err;
+        }
+        vfd->engine = VFD_ENGINE_DMA;
+        return VFD_OK;
+    }
+
+    vfd->scan_grid = VFD_GRIDS_MAX;
+    vfd->scan_blanking = false;
+    vfd->command_pending = false;
+    _idle_reset(vfd);
+
+    /* The callback's negative returns keep a fixed rate from here on */
+    uint64_t first = max6921_hal_time_us() + vfd->config.refresh_interval_us;
+    _stats_restart(vfd, first);
+    int32_t id = max6921_hal_alarm_at(first, _autorefresh_alarm, vfd);
+    if (id <= 0) {
+        return VFD_ERR_HARDWARE;
+    }
+    vfd->alarm_id = id;
+
+    vfd->engine = VFD_ENGINE_TIMER;
+    return VFD_OK;
+}
+
+vfd_error_t vfd_launch_core1_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (vfd->engine == VFD_ENGINE_CORE1) {
+        return VFD_OK;
+    }
+
+    /* Only one instance can own core 1 */
+    if (vfd->engine != VFD_ENGINE_NONE || g_vfd_core1_owner != NULL) {
+        return VFD_ERR_BUSY;
+    }
+
+    /* The PIO backend already scans with no CPU at all */
+    if (vfd->config.backend != VFD_BACKEND_SPI) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+    _async_wait(vfd);
+    return _core1_start(vfd);
+}
+
+vfd_error_t vfd_stop_autorefresh_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    switch (vfd->engine) {
+    case VFD_ENGINE_NONE:
+        return VFD_OK;
+
+    case VFD_ENGINE_DMA:
+        _stop_pio_scan(vfd);
+        break;
+
+    case VFD_ENGINE_TIMER:
+        if (!vfd->parked) {
+            max6921_hal_alarm_cancel(vfd->alarm_id);
+        }
+        vfd->command_pending = false;
+        /* Leave the tube blank rather than holding the last grid lit */
+        _write_vfd_command(vfd, 0);
+        break;
+
+    case VFD_ENGINE_CORE1:
+        _core1_stop();
+        break;
+    }
+
+    vfd->engine = VFD_ENGINE_NONE;
+    vfd->front = vfd->ready;
+    vfd->parked = false;
+    return VFD_OK;
+}
+
+bool vfd_is_autorefresh_running_ex(vfd_t *vfd) {
+    return vfd != NULL && vfd->engine != VFD_ENGINE_NONE;
+}
+
+bool vfd_is_dormant_ready_ex(vfd_t *vfd) {
+    return vfd != NULL && vfd->initialized && vfd->parked;
+}
+
+vfd_error_t vfd_get_stats_ex(vfd_t *vfd, vfd_stats_t *stats) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (stats == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+#if MAX6921_STATS
+    /* Retry until the copy did not overlap an update by the scanning side */
+    vfd_stats_state_t copy;
+    uint32_t seq;
+    do {
+        seq = vfd->stats.seq;
+        __dmb();
+        memcpy(&copy, (const void *)&vfd->stats, sizeof(copy));
+        __dmb();
+    } while ((seq & 1) || seq != vfd->stats.seq);
+
+    if (copy.reset_pending) {
+        memset(stats, 0, sizeof(*stats));
+        return VFD_OK;
+    }
+
+    stats->frames = copy.frames;
+    stats->frame_us_min = copy.frame_us.min;
+    stats->frame_us_avg = _stat_avg(&copy.frame_us);
+    stats->frame_us_max = copy.frame_us.max;
+    stats->dwell_us_min = copy.dwell_us.min;
+    stats->dwell_us_avg = _stat_avg(&copy.dwell_us);
+    stats->dwell_us_max = copy.dwell_us.max;
+    for (uint8_t grid = 0; grid < VFD_GRIDS_MAX; grid++) {
+        uint32_t count = copy.grid_dwell_count[grid];
+        stats->grid_dwell_us_avg[grid] = count ? (uint32_t)(copy.grid_dwell_sum[grid] / count) : 0;
+    }
+    stats->spi_us_min = copy.spi_us.min;
+    stats->spi_us_avg = _stat_avg(&copy.spi_us);
+    stats->spi_us_max = copy.spi_us.max;
+    stats->missed_deadlines = copy.missed;
+    stats->target_frame_us = (vfd->config.target_fps != 0) ? vfd->frame_us : 0;
+    stats->frames_late = copy.late;
+    return VFD_OK;
+#else
+    return VFD_ERR_UNSUPPORTED;
+#endif
+}
+
+vfd_error_t vfd_reset_stats_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+#if MAX6921_STATS
+    /* A CPU-driven engine owns the counters; let it clear them */
+    if (vfd->engine == VFD_ENGINE_TIMER || vfd->engine == VFD_ENGINE_CORE1) {
+        vfd->stats.reset_pending = true;
+    } else {
+        _stats_begin(&vfd->stats);
+        _stats_clear(&vfd->stats);
+        _stats_end(&vfd->stats);
+    }
+    return VFD_OK;
+#else
+    return VFD_ERR_UNSUPPORTED;
+#endif
+}
+
+vfd_error_t vfd_get_trace_ex(vfd_t *vfd, vfd_trace_entry_t *entries, uint32_t max_entries,
+                             uint32_t *count) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if ((entries == NULL && max_entries > 0) || count == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+#if MAX6921_TRACE
+    uint32_t end = vfd->trace.head;
+    uint32_t next = vfd->trace.start;
+    if (end - next > max_entries) {
+        next = end - max_entries;
+    }
+    *count = _trace_read(vfd, &next, end, entries, max_entries);
+    return VFD_OK;
+#else
+    *count = 0;
+    return VFD_ERR_UNSUPPORTED;
+#endif
+}
+
+vfd_error_t vfd_dump_trace_ex(vfd_t *vfd, vfd_trace_print_t print, void *user_data) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+    if (print == NULL) {
+        return VFD_ERR_INVALID_PARAM;
+    }
+
+#if MAX6921_TRACE
+    static const char *const kind_names[] = {"word", "latch", "command", "?"};
+
+    /* Up to what was recorded when the dump started, a few entries at a
+     * time; a slow print can lose the oldest to a running engine */
+    uint32_t end = vfd->trace.head;
+    uint32_t next = vfd->trace.start;
+    while (next != end) {
+        vfd_trace_entry_t chunk[16];
+        uint32_t count = _trace_read(vfd, &next, end, chunk, count_of(chunk));
+        for (uint32_t i = 0; i < count; i++) {
+            char line[48];
+            uint32_t data = chunk[i].data;
+            snprintf(line, sizeof(line), "trace,%lu,%s,%u,%05lx", (unsigned long)chunk[i].time_us,
+                     kind_names[VFD_TRACE_KIND(data)], VFD_TRACE_CHIP(data),
+                     (unsigned long)VFD_TRACE_VALUE(data));
+            print(line, user_data);
+        }
+    }
+    print("trace,end", user_data);
+    return VFD_OK;
+#else
+    (void)user_data;
+    return VFD_ERR_UNSUPPORTED;
+#endif
+}
+
+vfd_error_t vfd_reset_trace_ex(vfd_t *vfd) {
+    if (vfd == NULL || !vfd->initialized) {
+        return VFD_ERR_NOT_INITIALIZED;
+    }
+
+#if MAX6921_TRACE
+    /* The writer never reads start, so this needs no handshake */
+    vfd->trace.start = vfd->trace.head;
+    return VFD_OK;
+#else
+    return VFD_ERR_UNSUPPORTED;
+#endif
+}
+
+/* Default instance wrappers */
+
+vfd_t *vfd_default_instance(void) {
+    return &g_vfd_default;
+}
+
+vfd_error_t vfd_init(const vfd_config_t *config) {
+    return vfd_init_ex(&g_vfd_default, config);
+}
+
+bool vfd_is_initialized(void) {
+    return vfd_is_initialized_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_deinit(void) {
+    return vfd_deinit_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_calibrate_baudrate(uint32_t max_baudrate) {
+    return vfd_calibrate_baudrate_ex(&g_vfd_default, max_baudrate);
+}
+
+uint32_t vfd_get_baudrate(void) {
+    return vfd_get_baudrate_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_write_segments(uint8_t grid, uint8_t segments) {
+    return vfd_write_segments_ex(&g_vfd_default, grid, segments);
+}
+
+vfd_error_t vfd_read_segments(uint8_t grid, uint8_t *segments) {
+    return vfd_read_segments_ex(&g_vfd_default, grid, segments);
+}
+
+vfd_error_t vfd_write_digit(uint8_t grid, uint8_t digit) {
+    return vfd_write_digit_ex(&g_vfd_default, grid, digit);
+}
+
+vfd_error_t vfd_clear(void) {
+    return vfd_clear_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_refresh(void) {
+    return vfd_refresh_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_refresh_async(vfd_async_callback_t on_done, void *user_data) {
+    return vfd_refresh_async_ex(&g_vfd_default, on_done, user_data);
+}
+
+bool vfd_is_async_busy(void) {
+    return vfd_is_async_busy_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_commit(void) {
+    return vfd_commit_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_set_brightness(uint8_t level) {
+    return vfd_set_brightness_ex(&g_vfd_default, level);
+}
+
+vfd_error_t vfd_set_grid_brightness(uint8_t grid, uint8_t level) {
+    return vfd_set_grid_brightness_ex(&g_vfd_default, grid, level);
+}
+
+vfd_error_t vfd_write_string(const char *str) {
+    return vfd_write_string_ex(&g_vfd_default, str);
+}
+
+vfd_error_t vfd_write_region(uint8_t first_grid, uint8_t count, const uint8_t *patterns) {
+    return vfd_write_region_ex(&g_vfd_default, first_grid, count, patterns);
+}
+
+vfd_error_t vfd_write_string_at(uint8_t first_grid, uint8_t width, const char *str) {
+    return vfd_write_string_at_ex(&g_vfd_default, first_grid, width, str);
+}
+
+vfd_error_t vfd_post_update(const vfd_update_t *update) {
+    return vfd_post_update_ex(&g_vfd_default, update);
+}
+
+uint32_t vfd_get_update_overflows(void) {
+    return vfd_get_update_overflows_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_write_int(uint8_t first_grid, uint8_t width, int32_t value, vfd_align_t align) {
+    return vfd_write_int_ex(&g_vfd_default, first_grid, width, value, align);
+}
+
+vfd_error_t vfd_write_fixed(uint8_t first_grid, uint8_t width, int32_t value,
+                            uint8_t decimals, vfd_align_t align) {
+    return vfd_write_fixed_ex(&g_vfd_default, first_grid, width, value, decimals, align);
+}
+
+vfd_error_t vfd_write_hex(uint8_t first_grid, uint8_t width, uint32_t value, vfd_align_t align) {
+    return vfd_write_hex_ex(&g_vfd_default, first_grid, width, value, align);
+}
+
+vfd_error_t vfd_marquee_start(const vfd_marquee_config_t *config, const char *text) {
+    return vfd_marquee_start_ex(&g_vfd_default, config, text);
+}
+
+vfd_error_t vfd_marquee_append(const char *text) {
+    return vfd_marquee_append_ex(&g_vfd_default, text);
+}
+
+vfd_error_t vfd_marquee_stop(void) {
+    return vfd_marquee_stop_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_clock_start(const vfd_clock_config_t *config) {
+    return vfd_clock_start_ex(&g_vfd_default, config);
+}
+
+vfd_error_t vfd_clock_set_time(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    return vfd_clock_set_time_ex(&g_vfd_default, hours, minutes, seconds);
+}
+
+vfd_error_t vfd_clock_stop(void) {
+    return vfd_clock_stop_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_play_animation(const vfd_animation_t *animation, vfd_anim_callback_t on_done,
+                               void *user_data) {
+    return vfd_play_animation_ex(&g_vfd_default, animation, on_done, user_data);
+}
+
+vfd_error_t vfd_stop_animation(void) {
+    return vfd_stop_animation_ex(&g_vfd_default);
+}
+
+bool vfd_is_animation_playing(void) {
+    return vfd_is_animation_playing_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_transition(vfd_transition_t type, uint32_t duration_ms) {
+    return vfd_transition_ex(&g_vfd_default, type, duration_ms);
+}
+
+vfd_error_t vfd_set_grid_command(uint8_t grid, uint8_t command) {
+    return vfd_set_grid_command_ex(&g_vfd_default, grid, command);
+}
+
+vfd_error_t vfd_set_command(uint8_t command) {
+    return vfd_set_command_ex(&g_vfd_default, command);
+}
+
+vfd_error_t vfd_queue_command(uint8_t command) {
+    return vfd_queue_command_ex(&g_vfd_default, command);
+}
+
+vfd_display_buffer_t *vfd_get_buffer(void) {
+    return vfd_get_buffer_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_fill_buffer(uint8_t segments) {
+    return vfd_fill_buffer_ex(&g_vfd_default, segments);
+}
+
+vfd_error_t vfd_send_control_command(const vfd_control_command_t *cmd) {
+    return vfd_send_control_command_ex(&g_vfd_default, cmd);
+}
+
+vfd_error_t vfd_send_control_command_async(const vfd_control_command_t *cmd,
+                                           vfd_async_callback_t on_done, void *user_data) {
+    return vfd_send_control_command_async_ex(&g_vfd_default, cmd, on_done, user_data);
+}
+
+vfd_error_t vfd_start_autorefresh(void) {
+    return vfd_start_autorefresh_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_launch_core1(void) {
+    return vfd_launch_core1_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_stop_autorefresh(void) {
+    return vfd_stop_autorefresh_ex(&g_vfd_default);
+}
+
+bool vfd_is_autorefresh_running(void) {
+    return vfd_is_autorefresh_running_ex(&g_vfd_default);
+}
+
+bool vfd_is_dormant_ready(void) {
+    return vfd_is_dormant_ready_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_get_stats(vfd_stats_t *stats) {
+    return vfd_get_stats_ex(&g_vfd_default, stats);
+}
+
+vfd_error_t vfd_reset_stats(void) {
+    return vfd_reset_stats_ex(&g_vfd_default);
+}
+
+vfd_error_t vfd_get_trace(vfd_trace_entry_t *entries, uint32_t max_entries, uint32_t *count) {
+    return vfd_get_trace_ex(&g_vfd_default, entries, max_entries, count);
+}
+
+vfd_error_t vfd_dump_trace(vfd_trace_print_t print, void *user_data) {
+    return vfd_dump_trace_ex(&g_vfd_default, print, user_data);
+}
+
+vfd_error_t vfd_reset_trace(void) {
+    return vfd_reset_trace_ex(&g_vfd_default);
+}
+
+int vfd_segments_to_string(uint8_t segments, char *buffer, int buffer_size) {
+    if (buffer == NULL || buffer_size < 1) {
+        return 0;
+    }
+
+    static const char *segment_names[] = {"A", "B", "C", "D", "E", "F", "G", "H"};
+    int offset = 0;
+
+    buffer[0] = '\0';
+
+    for (int i = 0; i < 8; i++) {
+        if (segments & (1 << i)) {
+            if (offset > 0) {
+                offset += snprintf(buffer + offset, buffer_size - offset, " ");
+            }
+            offset += snprintf(buffer + offset, buffer_size - offset, "%s", segment_names[i]);
+
+            if (offset >= buffer_size - 1) {
+                break;
+            }
+        }
+    }
+
+    return offset;
+}
+
+uint8_t vfd_char_to_segments(char c) {
+    return ASCII_FONT[(uint8_t)c];
 }
 
 const char *vfd_strerror(vfd_error_t error) {
@@ -360,10 +4040,12 @@ const char *vfd_strerror(vfd_error_t error) {
         "VFD not initialized",
         "Grid index out of range",
         "Segment value out of range",
-        "Hardware initialization failed"
+        "Hardware initialization failed",
+        "Driver busy",
+        "Feature not enabled in this build"
     };
 
-    if (error >= 0 && error < 6) {
+    if (error >= 0 && error < 8) {
         return error_messages[error];
     }
 
@@ -26,6 +26,17 @@
 extern "C" {
 #endif
 
+/* Build-wide options (define for the library and the application alike) */
+#ifndef MAX6921_STATS
+#define MAX6921_STATS 0            /* 1: collect refresh timing for vfd_get_stats() */
+#endif
+#ifndef MAX6921_TRACE
+#define MAX6921_TRACE 0            /* 1: record words and latch edges for vfd_get_trace() */
+#endif
+#ifndef MAX6921_TRACE_SIZE
+#define MAX6921_TRACE_SIZE 256     /* Trace entries kept, a power of two */
+#endif
+
 /* Error codes returned by library functions */
 typedef enum {
     VFD_OK = 0,                    /* Operation successful */
@@ -33,9 +44,46 @@ typedef enum {
     VFD_ERR_NOT_INITIALIZED = 2,   /* VFD not initialized */
     VFD_ERR_INVALID_GRID = 3,      /* Grid index out of range */
     VFD_ERR_INVALID_SEGMENT = 4,   /* Segment value out of range */
-    VFD_ERR_HARDWARE = 5           /* Hardware initialization failed */
+    VFD_ERR_HARDWARE = 5,          /* Hardware initialization failed */
+    VFD_ERR_BUSY = 6,              /* Previous request still pending */
+    VFD_ERR_UNSUPPORTED = 7        /* Feature not enabled in this build */
 } vfd_error_t;
 
+/* Transport used to shift words into the MAX6921 */
+typedef enum {
+    VFD_BACKEND_SPI = 0,           /* Hardware SPI block + GPIO latch */
+    VFD_BACKEND_PIO = 1            /* PIO state machine, DMA-fed in autorefresh */
+} vfd_backend_t;
+
+/* How the scan spends its time on blank grids */
+typedef enum {
+    VFD_SCAN_FULL = 0,             /* Every grid gets its slot, lit or not */
+    VFD_SCAN_SHORTEN,              /* Skip blank grids: faster frames, lit grids brighter */
+    VFD_SCAN_SHORTEN_CONSTANT,     /* Skip blank grids, brightness independent of content */
+    VFD_SCAN_STRETCH               /* Same frame rate, lit grids share the freed time */
+} vfd_scan_mode_t;
+
+/* What pulses LOAD after each SPI burst */
+typedef enum {
+    VFD_LATCH_GPIO = 0,            /* Software pulse on pin_latch after the write returns */
+    VFD_LATCH_SPI_CS               /* pin_latch is the SPI block's CSn; it rises after the last bit */
+} vfd_latch_t;
+
+/* Most grids one MAX6921 scans; its 20 outputs also carry the 8 segments */
+#define VFD_GRIDS_MAX 12
+
+/* Output map entry for a signal that is not wired */
+#define VFD_OUTPUT_NONE 0xFF
+
+/* MAX6921 output (0..19) each signal is wired to, the same on every chip
+ * Grids and segments must each have an output of their own; a command bit
+ * left VFD_OUTPUT_NONE makes the commands that set it invalid. */
+typedef struct {
+    uint8_t grid[VFD_GRIDS_MAX];   /* Grid of each scan step, first `grids` used */
+    uint8_t segment[8];            /* Font segments A=0 .. G=6, DP=7 */
+    uint8_t command[3];            /* Command bits 0..2 */
+} vfd_output_map_t;
+
 /* VFD configuration structure */
 typedef struct {
     uint32_t spi_baudrate;         /* SPI baud rate (default: 2000000) */
@@ -43,8 +91,28 @@ typedef struct {
     uint8_t pin_spi_clk;           /* SCK pin (default: 10) */
     uint8_t pin_latch;             /* Latch/CS pin (default: 13) */
     uint16_t refresh_interval_us;  /* Microseconds between grid refreshes (default: 1500) */
+    vfd_backend_t backend;         /* Transport (default: VFD_BACKEND_SPI) */
+    uint8_t pio_index;             /* PIO block for VFD_BACKEND_PIO, 0 or 1 (default: 0) */
+    uint8_t spi_index;             /* SPI block for VFD_BACKEND_SPI, 0 or 1 (default: 1) */
+    uint8_t chain_length;          /* Daisy-chained MAX6921s, 1..VFD_CHAIN_MAX (default: 1) */
+    vfd_scan_mode_t scan_mode;     /* Blank grid handling (default: VFD_SCAN_FULL) */
+    uint16_t target_fps;           /* Frame rate to hold, 0: grids * refresh_interval_us (default: 0) */
+    bool low_power;                /* Sleep between steps, park on a static blank display (default: false) */
+    uint16_t idle_fps;             /* Frame rate floor once the display is static, 0: off (default: 0) */
+    uint16_t idle_after_ms;        /* Time without a commit before it counts as static (default: 1000) */
+    vfd_latch_t latch;             /* LOAD source for VFD_BACKEND_SPI (default: VFD_LATCH_GPIO) */
+    uint8_t pin_spi_rx;            /* MISO pin wired to the last DOUT, for calibration (default: 12) */
+    uint8_t grids;                 /* Grids per chip, 1..VFD_GRIDS_MAX (default: 9) */
+    const vfd_output_map_t *output_map; /* Wiring, read by init only; NULL: vfd_default_output_map() */
+    const uint8_t *boot_frame;     /* grids * chain_length patterns, read by init only, which starts
+                                    * scanning them; NULL: blank, no engine (default: NULL) */
 } vfd_config_t;
 
+/* Most MAX6921s in one DIN -> DOUT cascade, and the burst that loads them
+ * (whole 16-bit frames, which VFD_LATCH_SPI_CS needs) */
+#define VFD_CHAIN_MAX 4
+#define VFD_BURST_BYTES_MAX ((20 * VFD_CHAIN_MAX + 15) / 16 * 2)
+
 /* Standard 7-segment digit mappings */
 typedef enum {
     VFD_DIGIT_0 = 0b00111111,      /* Segments: A B C D E F */
@@ -62,20 +130,400 @@ typedef enum {
     VFD_BLANK = 0b00000000         /* All segments off */
 } vfd_segment_pattern_t;
 
-/* Display buffer (one entry per grid) */
-typedef uint8_t vfd_display_buffer_t[9];
+/* Display buffer (one entry per grid, the first `grids` used) */
+typedef uint8_t vfd_display_buffer_t[VFD_GRIDS_MAX];
+
+/* Brightness levels 0 (off) .. VFD_BRIGHTNESS_MAX (full) */
+#define VFD_BRIGHTNESS_MAX 15
+
+/* Autonomous scan engines */
+typedef enum {
+    VFD_ENGINE_NONE = 0,           /* Only blocking vfd_refresh() */
+    VFD_ENGINE_TIMER,              /* Alarm IRQ on the calling core */
+    VFD_ENGINE_DMA,                /* PIO state machine fed by chained DMA */
+    VFD_ENGINE_CORE1               /* Dedicated loop on core 1 */
+} vfd_engine_t;
+
+/* One display frame: patterns plus their ready-to-send words
+ * Each grid slot is a lit word followed by a blank word; the brightness
+ * level decides how the slot is split between the two. Both are laid out
+ * [lit 0, blank 0, lit 1, blank 1, ...]: words[] as PIO FIFO words so DMA
+ * can stream it unchanged, bursts[] as the SPI bytes for the whole chain.
+ */
+typedef struct {
+    vfd_display_buffer_t segments[VFD_CHAIN_MAX]; /* One buffer per chip */
+    uint8_t levels[VFD_GRIDS_MAX]; /* Brightness 0..VFD_BRIGHTNESS_MAX per grid */
+    uint8_t commands[VFD_CHAIN_MAX][VFD_GRIDS_MAX]; /* Command bits held through each slot */
+    uint16_t scan_mask;            /* Steps the scan visits */
+    uint16_t lit_mask;             /* Steps that light a grid or hold command bits */
+    uint32_t period_us;            /* Sum of the visited steps' slots */
+    uint32_t slot_us[VFD_GRIDS_MAX]; /* Length of each step's slot for timed engines */
+    uint32_t on_us[VFD_GRIDS_MAX]; /* Lit part of each slot for timed engines */
+    union {
+        uint32_t words[2 * VFD_GRIDS_MAX]; /* VFD_BACKEND_PIO */
+        uint8_t bursts[2 * VFD_GRIDS_MAX][VFD_BURST_BYTES_MAX]; /* VFD_BACKEND_SPI */
+    };
+} vfd_frame_t;
+
+#define VFD_FRAME_COUNT 3
+
+/* Records the update queue holds; a power of two. It sizes vfd_t, so the
+ * library and the application must agree on it. */
+#ifndef VFD_UPDATE_QUEUE_SIZE
+#define VFD_UPDATE_QUEUE_SIZE 16
+#endif
+
+typedef enum {
+    VFD_UPDATE_SEGMENTS = 0,       /* data[i]: pattern for each grid in mask */
+    VFD_UPDATE_COMMAND = 1         /* data[0]: command bits held by each grid in mask */
+} vfd_update_kind_t;
+
+/* One posted update: grids grids * chip + i for every bit i set in mask */
+typedef struct {
+    uint8_t kind;                  /* vfd_update_kind_t */
+    uint8_t chip;
+    uint16_t mask;                 /* Bits 0 .. grids - 1 */
+    uint8_t data[VFD_GRIDS_MAX];
+} vfd_update_t;
+
+/* Posted updates the scanner has taken off the queue (private)
+ * While a scan runs, each frame boundary drains the queue into these
+ * patterns and command bits and sends them over the frame it scans. The
+ * next commit holds the scanner off and folds them into the back buffer.
+ */
+typedef struct {
+    volatile bool held;            /* A commit is folding them in; scanner keeps its bursts */
+    volatile bool rendering;       /* Scanner is draining or encoding */
+    bool fresh;                    /* Scanner: records were drained this frame */
+    uint16_t steps;                /* Steps with anything posted */
+    uint16_t scan_mask;            /* Steps sent from bursts[] this frame */
+    uint16_t segment_mask[VFD_CHAIN_MAX]; /* Steps with a posted pattern, per chip */
+    uint16_t command_mask[VFD_CHAIN_MAX]; /* Steps with posted command bits, per chip */
+    uint8_t segments[VFD_CHAIN_MAX][VFD_GRIDS_MAX];
+    uint8_t commands[VFD_CHAIN_MAX][VFD_GRIDS_MAX];
+    const void *rendered_frame;    /* Scanned frame bursts[] was built against */
+    uint8_t bursts[2 * VFD_GRIDS_MAX][VFD_BURST_BYTES_MAX]; /* Lit and blank burst per step */
+} vfd_posted_state_t;
+
+/* One animation frame: patterns for the first chip's grids and how long they show
+ * Arrays of these can be const, so animations stay in XIP flash. */
+typedef struct {
+    vfd_display_buffer_t segments;
+    uint16_t hold_ms;              /* 1..65535 */
+} vfd_anim_frame_t;
+
+typedef struct {
+    const vfd_anim_frame_t *frames;
+    uint16_t frame_count;
+    bool loop;                     /* Start over after the last frame; false: one shot */
+} vfd_animation_t;
+
+struct vfd_instance;
+
+/* Runs in alarm IRQ context once a one-shot animation has finished */
+typedef void (*vfd_anim_callback_t)(struct vfd_instance *vfd, void *user_data);
+
+/* Runs in IRQ context once a non-blocking refresh or command has finished */
+typedef void (*vfd_async_callback_t)(struct vfd_instance *vfd, void *user_data);
+
+/* Change-over from the shown frame to a commit, see vfd_transition() */
+typedef enum {
+    VFD_TRANSITION_CUT = 0,        /* Plain commit */
+    VFD_TRANSITION_FADE,           /* Changed grids cross-fade */
+    VFD_TRANSITION_ROLL,           /* Changed digits roll up, odometer style */
+    VFD_TRANSITION_SLIDE,          /* The new frame pushes the old one out to the left */
+    VFD_TRANSITION_WIPE            /* Grids change over one at a time, left to right */
+} vfd_transition_t;
+
+/* Animation player (private)
+ * Frames are encoded into one of two stages as they come due; the scan
+ * engine (or DMA) is pointed at a stage instead of the committed frame.
+ * Without an animation it plays a transition, its stages rendered from
+ * the frame it started from and the latest commit.
+ */
+typedef struct {
+    volatile bool active;
+    const vfd_animation_t *animation;
+    uint16_t index;                /* Frame encoded next */
+    vfd_anim_callback_t on_done;
+    void *user_data;
+    int32_t alarm_id;
+    volatile int8_t ready_stage;   /* Latest encoded stage, -1 for none */
+    volatile int8_t scan_stage;    /* Stage the CPU scanner reads, -1 for none */
+    vfd_transition_t transition;
+    uint16_t stage_count;          /* Transition stages, the old frame first */
+    uint32_t hold_us;              /* Transition: how long each stage shows */
+    vfd_display_buffer_t from[VFD_CHAIN_MAX]; /* Transition: the frame it started from */
+    uint8_t from_levels[VFD_GRIDS_MAX];
+    vfd_frame_t stage[2];
+} vfd_player_state_t;
+
+/* Marquee scroll direction */
+typedef enum {
+    VFD_SCROLL_LEFT = 0,           /* Text moves left, read order */
+    VFD_SCROLL_RIGHT = 1           /* Text moves right (loop mode only) */
+} vfd_scroll_dir_t;
+
+/* Marquee setup, see vfd_marquee_start() */
+typedef struct {
+    uint8_t first_grid;            /* Window on the display */
+    uint8_t width;                 /* Grids in the window */
+    uint32_t step_us;              /* Time per one-grid step */
+    vfd_scroll_dir_t direction;
+    bool loop;                     /* Repeat the text; false: stream appended text */
+    uint8_t *strip;                /* Caller storage for the rendered glyphs */
+    uint16_t strip_size;           /* Glyphs strip can hold */
+} vfd_marquee_config_t;
+
+/* Marquee window kept by the scanner (private)
+ * The application renders text into the strip and moves head; the scanner
+ * moves pos and re-encodes bursts[] only when the window changed.
+ */
+typedef struct {
+    volatile bool active;
+    volatile bool rendering;       /* Scanner is reading the strip */
+    bool loop;
+    bool can_fold;                 /* Last glyph can take a following '.' */
+    vfd_scroll_dir_t direction;
+    uint8_t first_grid;
+    uint8_t width;
+    const void *rendered_frame;    /* Scanned frame bursts[] was built against */
+    uint16_t steps;                /* Scan steps the window covers */
+    uint16_t scan_mask;            /* Steps sent from bursts[] this frame */
+    uint8_t *strip;
+    uint32_t length;               /* Loop: text length; stream: strip size */
+    volatile uint32_t head;        /* Glyphs rendered so far */
+    volatile uint32_t pos;         /* Glyph shown in the window's first grid */
+    volatile uint32_t gen;         /* Bumped when the strip changes */
+    uint32_t rendered_gen;
+    uint32_t step_us;
+    uint64_t next_step;
+    uint8_t bursts[VFD_GRIDS_MAX][VFD_BURST_BYTES_MAX];
+} vfd_marquee_state_t;
+
+/* Clock face, see vfd_clock_start() */
+typedef enum {
+    VFD_CLOCK_HH_MM_SS = 0,        /* "12-34-56", 8 grids */
+    VFD_CLOCK_HH_MM,               /* "12-34", 5 grids */
+    VFD_CLOCK_HH_MM_SS_DOTS        /* "12.34.56", 6 grids */
+} vfd_clock_layout_t;
+
+/* What moves the clock on by one second */
+typedef enum {
+    VFD_CLOCK_TIMER = 0,           /* Scanner, on absolute 1 s deadlines of the us timer */
+    VFD_CLOCK_RTC,                 /* RP2040 RTC alarm; the time is read from the RTC */
+    VFD_CLOCK_PPS                  /* Rising edge on pin_pps, e.g. a GPS 1PPS output */
+} vfd_clock_source_t;
+
+/* Clock setup, see vfd_clock_start() */
+typedef struct {
+    uint8_t first_grid;            /* Leftmost grid of the face */
+    vfd_clock_layout_t layout;
+    bool hour12;                   /* 1-12 with a blank leading zero, PM on the last DP */
+    vfd_clock_source_t source;
+    uint8_t pin_pps;               /* Input for VFD_CLOCK_PPS */
+} vfd_clock_config_t;
+
+/* Clock face kept by the scanner (private)
+ * The source only counts seconds; the scanner turns the time into glyphs
+ * at a frame boundary and re-encodes the steps whose glyph changed.
+ */
+typedef struct {
+    volatile bool active;
+    volatile bool rendering;       /* Scanner is reading the clock */
+    vfd_clock_source_t source;
+    vfd_clock_layout_t layout;
+    bool hour12;
+    uint8_t first_grid;
+    uint8_t width;
+    uint8_t pin_pps;
+    uint16_t steps;                /* Scan steps the face covers */
+    uint16_t scan_mask;            /* Steps sent from bursts[] this frame */
+    volatile uint32_t ticks;       /* Seconds counted by the timer or PPS source */
+    volatile uint32_t rtc_time;    /* RTC source: time of day read at the last alarm */
+    uint32_t base_ticks;           /* ticks when base_time was set */
+    uint32_t base_time;            /* Time of day at base_ticks, in seconds */
+    bool time_pending;             /* base_time set with no RTC clock running, for its start */
+    uint32_t shown;                /* Scanner: ticks or RTC time the glyphs show */
+    bool redraw;                   /* Scanner: rebuild every glyph at the next frame */
+    uint64_t next_tick;            /* Timer source: next second boundary */
+    const void *rendered_frame;    /* Scanned frame bursts[] was built against */
+    uint8_t glyphs[8];
+    uint8_t bursts[VFD_GRIDS_MAX][VFD_BURST_BYTES_MAX];
+} vfd_clock_state_t;
+
+#if MAX6921_STATS
+/* Running min/max/sum of one measured quantity (private) */
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+    uint64_t sum;
+} vfd_stat_acc_t;
+
+/* Timing collected by the scan paths (private)
+ * Written by whoever scans (caller, timer ISR or core 1) under a sequence
+ * count, so readers on either core can take a consistent copy without
+ * ever blocking the writer.
+ */
+typedef struct {
+    volatile uint32_t seq;         /* Odd while an update is in progress */
+    volatile bool reset_pending;   /* Writer clears everything at next update */
+    uint32_t frames;
+    uint32_t missed;
+    uint32_t late;
+    vfd_stat_acc_t frame_us;
+    vfd_stat_acc_t dwell_us;
+    vfd_stat_acc_t spi_us;
+    uint64_t grid_dwell_sum[VFD_GRIDS_MAX];
+    uint32_t grid_dwell_count[VFD_GRIDS_MAX];
+    uint64_t frame_start;          /* Start of the frame being scanned, 0 if none */
+    uint64_t step_start;           /* Start of the current grid step, 0 if none */
+    uint8_t step_grid;             /* Grid of the current step */
+    bool frame_idle;               /* Current frame is stretched to the idle floor */
+    uint64_t target;               /* Timer engine: when the current tick was due */
+} vfd_stats_state_t;
+#endif
+
+/* One trace record: when, and what went to the chain
+ * data is [kind:2 | chip:2 | 8 unused | value:20]; the value is the word
+ * shifted into chip for VFD_TRACE_WORD and the command bits for
+ * VFD_TRACE_COMMAND. time_us is time_us_32(), wrapping every 71 minutes.
+ */
+typedef enum {
+    VFD_TRACE_WORD = 0,            /* A chip's 20-bit word was shifted out */
+    VFD_TRACE_LATCH,               /* LOAD: the words just shifted reach the outputs */
+    VFD_TRACE_COMMAND              /* A standalone command word follows (0: blanking) */
+} vfd_trace_kind_t;
+
+typedef struct {
+    uint32_t time_us;
+    uint32_t data;
+} vfd_trace_entry_t;
+
+#define VFD_TRACE_KIND(data) ((vfd_trace_kind_t)((data) >> 30))
+#define VFD_TRACE_CHIP(data) ((uint8_t)(((data) >> 28) & 0x3))
+#define VFD_TRACE_VALUE(data) ((data) & 0xFFFFFu)
+
+#if MAX6921_TRACE
+#if (MAX6921_TRACE_SIZE & (MAX6921_TRACE_SIZE - 1)) != 0
+#error "MAX6921_TRACE_SIZE must be a power of two"
+#endif
+
+/* Trace ring (private)
+ * Written only by whoever sends (caller, timer ISR, core 1 or the
+ * non-blocking transfer IRQs); head runs freely and is published after
+ * each entry, so readers can tell which entries were overwritten.
+ */
+typedef struct {
+    volatile uint32_t head;        /* Entries ever written */
+    volatile uint32_t start;       /* Reader: head at the last reset */
+    vfd_trace_entry_t entries[MAX6921_TRACE_SIZE];
+} vfd_trace_state_t;
+#endif
+
+/**
+ * Driver instance
+ * One per MAX6921, passed to the *_ex functions. Declare it static (or
+ * otherwise zero it) before vfd_init_ex(); all members are private.
+ *
+ * Frames rotate between three roles without copying: back (written by the
+ * API), ready (last commit) and front (being scanned). The scan engine only
+ * ever moves front to ready at a frame boundary; the writer only ever picks
+ * a new back that is neither of those.
+ */
+typedef struct vfd_instance {
+    bool initialized;
+    vfd_config_t config;
+    uint8_t grid_count;            /* grids per chip, times the chain */
+    uint8_t steps;                 /* Scan steps per frame, config.grids */
+    uint16_t all_steps;            /* Mask with every step set */
+    uint8_t command_mask;          /* Command bits the output map wires */
+    uint8_t grid_slot[VFD_GRIDS_MAX * VFD_CHAIN_MAX]; /* Grid to chip << 4 | step */
+    uint32_t grid_bits[VFD_GRIDS_MAX]; /* Output bit of each step's grid */
+    uint32_t segment_bits[2][16];  /* Outputs of a segment byte's low and high nibble */
+    uint32_t command_bits[8];      /* Outputs of each command value */
+    uint8_t burst_bytes;           /* SPI bytes per scan step */
+    uint32_t baudrate;             /* SPI clock actually running */
+    uint32_t frame_us;             /* Period of a full frame, one slot per step */
+    uint32_t idle_frame_us;        /* Frame period at the idle floor, 0: no floor */
+    vfd_frame_t frames[VFD_FRAME_COUNT];
+    uint8_t back;                  /* Frame targeted by write APIs */
+    volatile uint8_t ready;        /* Latest committed frame */
+    volatile uint8_t front;        /* Frame being scanned out */
+    uint16_t stale[VFD_FRAME_COUNT]; /* Grids older than the latest commit */
+    uint16_t dirty;                /* Grids written since the last commit */
+    bool buffer_shared;            /* vfd_get_buffer() handed out the back buffer */
+    int32_t alarm_id;              /* Timer engine alarm */
+    volatile vfd_engine_t engine;  /* What is scanning the front frame */
+    volatile bool latching;        /* Engine is mid-way through moving front */
+    volatile bool command_pending;
+    uint8_t pending_command;
+    volatile uint8_t queued_command; /* Bits for the next scan step, VFD_COMMAND_QUEUED set */
+    uint8_t step_command;          /* Scanner: bits OR'd into the current step */
+    uint8_t scan_grid;
+    bool scan_blanking;            /* Timer ISR is between lit and blank word */
+    volatile uint32_t commit_seq;  /* Bumped by every commit */
+    uint32_t seen_seq;             /* Scanner: commit_seq at the last frame start */
+    uint64_t seen_us;              /* Scanner: when seen_seq last changed */
+    uint32_t scan_scale;           /* Scanner: slot stretch for the idle floor, 1/256 */
+    volatile bool parked;          /* Engine stopped stepping on a static blank display */
+    uint8_t step_burst[VFD_BURST_BYTES_MAX]; /* Scanner: step burst with its queued command */
+    volatile bool async_busy;      /* A non-blocking refresh or command is in flight */
+    volatile bool async_shifting;  /* Its current burst is on the bus, LOAD still due */
+    bool async_ready;              /* HAL non-blocking writes claimed */
+    bool async_command;            /* In flight is a standalone command word */
+    bool async_blanking;           /* Next async word is the step's blank word */
+    uint8_t async_grid;            /* Step of the async frame, steps past the last */
+    uint64_t async_slot;           /* Start of that step's slot */
+    vfd_async_callback_t async_done;
+    void *async_user;
+    uint8_t async_burst[VFD_BURST_BYTES_MAX]; /* Standalone command word */
+    vfd_update_t updates[VFD_UPDATE_QUEUE_SIZE]; /* Posted, not yet applied */
+    volatile uint16_t update_head; /* Producer: next record to write */
+    volatile uint16_t update_tail; /* Commit: next record to apply */
+    volatile uint32_t update_overflows; /* Posts rejected because the queue was full */
+    vfd_posted_state_t posted;
+    uint32_t pio_sm;
+    uint32_t pio_offset;
+    uint32_t pio_hold_units;       /* Hold units per grid slot, lit + blank */
+    int dma_data_chan;
+    int dma_ctrl_chan;
+    const uint32_t *dma_frame_addr;
+    vfd_marquee_state_t marquee;
+    vfd_clock_state_t clock;
+    vfd_player_state_t player;
+#if MAX6921_STATS
+    vfd_stats_state_t stats;
+#endif
+#if MAX6921_TRACE
+    vfd_trace_state_t trace;
+#endif
+} vfd_t;
 
 /* Initialization and Configuration */
 
 /**
  * Get default VFD configuration
- * Returns: SPI 2MHz, MOSI pin 11, SCK pin 10, Latch pin 13, refresh 1500us
+ * Returns: SPI 2MHz, MOSI pin 11, SCK pin 10, Latch pin 13, refresh 1500us,
+ * SPI backend on spi1, 9 grids wired as on the IV-18 board
  */
 vfd_config_t vfd_default_config(void);
 
+/**
+ * Get the default wiring for a tube of grids grids
+ * Grids 0-8 on outputs 16-8, grids 9-11 on 17-19, segments on 7-0 and
+ * command bits on the outputs of 17-19 the grids leave free. Start from
+ * this to describe a board wired in another order.
+ */
+vfd_output_map_t vfd_default_output_map(uint8_t grids);
+
 /**
  * Initialize the VFD driver
- * Must be called before any other VFD operations
+ * Must be called before any other VFD operations. Brings up the transport
+ * and latch and blanks the chips' power-on contents; stdio is left to the
+ * application. With a boot_frame, that frame is latched and the background
+ * engine (vfd_start_autorefresh()) is already scanning it on return.
  */
 vfd_error_t vfd_init(const vfd_config_t *config);
 
@@ -89,17 +537,44 @@ bool vfd_is_initialized(void);
  */
 vfd_error_t vfd_deinit(void);
 
+/**
+ * Find the fastest SPI clock the board carries, and switch to it
+ * Needs the last chip's DOUT wired to pin_spi_rx. Known patterns go round
+ * the chain at rates rising by a quarter from spi_baudrate up to
+ * max_baudrate, and each is checked against what DOUT shifts back. The
+ * bus then runs at three quarters of the fastest clean rate (never below
+ * spi_baudrate); vfd_get_baudrate() reports it. The shift registers are
+ * left blank and nothing is latched with VFD_LATCH_GPIO; a CSn latch
+ * blanks the tube until the next refresh.
+ * Returns VFD_ERR_HARDWARE, keeping the old rate, if even spi_baudrate
+ * does not read back, VFD_ERR_BUSY while an engine or a transfer owns the
+ * bus, and VFD_ERR_UNSUPPORTED on the PIO backend.
+ */
+vfd_error_t vfd_calibrate_baudrate(uint32_t max_baudrate);
+
+/**
+ * SPI clock the bus is running at, as the hardware divider set it
+ * 0 if not initialized
+ */
+uint32_t vfd_get_baudrate(void);
+
 /* Display Control */
 
 /**
  * Write segment pattern to a specific grid
- * Grid: 0-8 (left to right)
- * Does not update display until vfd_refresh() is called
+ * Grid: 0 to grids - 1 (left to right, 0-8 by default); with chain_length
+ * > 1, chip n's tube follows as grids n * grids onwards
+ * Does not update display until vfd_commit() or vfd_refresh() is called
+ *
+ * All write APIs target the back buffer and only mark the grid dirty, and
+ * only if its pattern changed; the ready-to-send frame word is encoded
+ * once, at the next commit.
  */
 vfd_error_t vfd_write_segments(uint8_t grid, uint8_t segments);
 
 /**
  * Read current segment pattern from a grid
+ * Reads the back buffer, so uncommitted writes are included
  */
 vfd_error_t vfd_read_segments(uint8_t grid, uint8_t *segments);
 
@@ -115,22 +590,251 @@ vfd_error_t vfd_clear(void);
 
 /**
  * Refresh the display
- * Updates all grids with values from the buffer
+ * Commits the back buffer, then sends all grids of the front buffer
+ * Returns right after the commit while autorefresh is running
  */
 vfd_error_t vfd_refresh(void);
 
+/**
+ * Refresh the display without waiting for it
+ * Commits, then scans one frame in the background: each burst goes out by
+ * DMA, LOAD is pulsed from the completion IRQ and an alarm times the slots,
+ * exactly as the blocking vfd_refresh() would. on_done (may be NULL) runs
+ * from an IRQ at the end of the last slot; vfd_is_async_busy() polls the
+ * same thing. While one is in flight, commits are held back as for a
+ * running engine and blocking calls that use the bus wait for it first.
+ * Returns VFD_ERR_BUSY if a transfer is in flight or an engine owns
+ * the bus, VFD_ERR_UNSUPPORTED on the PIO backend and VFD_ERR_HARDWARE
+ * if no DMA channels are free.
+ */
+vfd_error_t vfd_refresh_async(vfd_async_callback_t on_done, void *user_data);
+
+/**
+ * Check whether a non-blocking refresh or command is still in flight
+ */
+bool vfd_is_async_busy(void);
+
+/**
+ * Commit the back buffer
+ * Encodes the dirty grids and publishes the back buffer with a single index
+ * (or DMA address) flip. A running engine swaps it in at its next frame
+ * boundary, so a multi-grid update is never shown half done. Neither side
+ * copies a frame or takes a lock; only grids changed by this commit are
+ * carried over into the new back buffer.
+ */
+vfd_error_t vfd_commit(void);
+
+/**
+ * Set brightness of all grids (0-VFD_BRIGHTNESS_MAX)
+ * Each grid slot is split PWM-style into a lit and a blanked part inside the
+ * scan itself (timer, core 1, PIO/DMA or blocking refresh), so dimming costs
+ * no CPU time and keeps the frame rate. Like any write it targets the back
+ * buffer and takes effect on the next commit.
+ */
+vfd_error_t vfd_set_brightness(uint8_t level);
+
+/**
+ * Set brightness of a single grid (0-VFD_BRIGHTNESS_MAX)
+ * Chained chips share each LOAD pulse, so the level applies to the same
+ * step (grid % grids) on every tube of the chain.
+ */
+vfd_error_t vfd_set_grid_brightness(uint8_t grid, uint8_t level);
+
 /**
  * Write a string to the display
- * Supported: '0'-'9', '-', '.', ' '
- * Max 9 characters (truncates if longer)
+ * Every character is one font lookup (see vfd_char_to_segments()); a '.'
+ * after a character folds into its decimal point. Grids past the end of
+ * the text are blanked. Max `grids` characters per chip in the chain (truncates
+ * if longer).
  */
 vfd_error_t vfd_write_string(const char *str);
 
+/**
+ * Write count patterns into grids [first_grid, first_grid + count)
+ * Other grids keep their contents; only grids whose pattern changes are
+ * re-encoded at the next commit.
+ */
+vfd_error_t vfd_write_region(uint8_t first_grid, uint8_t count, const uint8_t *patterns);
+
+/**
+ * Write a string into grids [first_grid, first_grid + width)
+ * Same rendering as vfd_write_string(), confined to the window: text is
+ * cut at the window's end, unused grids in it are blanked and grids
+ * outside it are left alone.
+ */
+vfd_error_t vfd_write_string_at(uint8_t first_grid, uint8_t width, const char *str);
+
+/* Interrupt-Safe Updates */
+
+/**
+ * Post an update from an interrupt (or any single other context)
+ * Copies the record into a lock-free single-producer ring in constant time,
+ * without disabling interrupts or waiting. A running timer or core 1
+ * engine takes records at its next frame boundary and shows them over the
+ * committed frame; the next commit takes them into the back buffer, in
+ * order, before encoding. Either way they land in whole frames. A full ring rejects the record with VFD_ERR_BUSY and counts it, so
+ * nothing is dropped silently. Only one context may post per instance.
+ */
+vfd_error_t vfd_post_update(const vfd_update_t *update);
+
+/**
+ * Posts rejected so far because the ring was full
+ */
+uint32_t vfd_get_update_overflows(void);
+
+/* Field alignment for the numeric writers */
+typedef enum {
+    VFD_ALIGN_RIGHT = 0,           /* Blank-padded on the left */
+    VFD_ALIGN_LEFT = 1,            /* Blank-padded on the right */
+    VFD_ALIGN_ZERO_PAD = 2         /* Right-aligned, leading zeros after any sign */
+} vfd_align_t;
+
+/**
+ * Write a signed integer into grids [first_grid, first_grid + width)
+ * Digits are produced straight into the back buffer, no printf or string.
+ * The rest of the display is left untouched. If the value does not fit,
+ * the field shows dashes and VFD_ERR_INVALID_PARAM is returned.
+ */
+vfd_error_t vfd_write_int(uint8_t first_grid, uint8_t width, int32_t value, vfd_align_t align);
+
+/**
+ * Write a fixed-point value: value / 10^decimals, e.g. (2150, 2) -> "21.50"
+ * The decimal point is folded into the digit before it, and there is
+ * always a digit before the point ("0.05"). decimals must be < width.
+ */
+vfd_error_t vfd_write_fixed(uint8_t first_grid, uint8_t width, int32_t value,
+                            uint8_t decimals, vfd_align_t align);
+
+/**
+ * Write an unsigned value in hex (0-9 A b C d E F)
+ */
+vfd_error_t vfd_write_hex(uint8_t first_grid, uint8_t width, uint32_t value, vfd_align_t align);
+
+/* Marquee */
+
+/**
+ * Scroll text through a window of the display
+ * The text is rendered once, through the same font as vfd_write_string(),
+ * into config->strip; after that each step only moves the window's offset
+ * and re-encodes the window's grids, with no string handling or copying.
+ * The scan engine (timer or core 1, or each vfd_refresh() without one)
+ * advances the window at its frame boundaries, at most one grid per frame.
+ *
+ * The window is drawn over the committed frame at scan time: grids outside
+ * it update as usual, and the buffer underneath shows again after
+ * vfd_marquee_stop(). Every run starts with width blank glyphs, so the
+ * text enters from the edge.
+ *
+ * loop: text plus that gap repeats forever and must fit in the strip.
+ * Otherwise the strip is a ring: vfd_marquee_append() adds text and the
+ * window stops when it reaches the end of what has been appended.
+ * Starting again replaces a running marquee. Returns VFD_ERR_UNSUPPORTED on
+ * the PIO backend, whose frames DMA streams without the CPU.
+ */
+vfd_error_t vfd_marquee_start(const vfd_marquee_config_t *config, const char *text);
+
+/**
+ * Append text to a streaming marquee
+ * All or nothing: returns VFD_ERR_BUSY if the ring cannot take the whole
+ * text yet, VFD_ERR_INVALID_PARAM for a loop marquee.
+ */
+vfd_error_t vfd_marquee_append(const char *text);
+
+/**
+ * Stop the marquee; the scanner drops the window at its next frame boundary
+ */
+vfd_error_t vfd_marquee_stop(void);
+
+/* Clock */
+
+/**
+ * Show a running clock without a write loop
+ * The source only counts seconds, from an IRQ or the scanner's own
+ * deadlines, so the time never drifts with the application's timing. At
+ * its next frame boundary the scan engine (timer or core 1, or each
+ * vfd_refresh() without one) turns the new time into glyphs and re-encodes
+ * only the steps whose glyph changed, usually one or two.
+ *
+ * The face is drawn over the committed frame, like a marquee window, so
+ * grids outside it update as usual and the ones under it show again after
+ * vfd_clock_stop(). It must not overlap a running marquee (VFD_ERR_BUSY).
+ * VFD_CLOCK_RTC and VFD_CLOCK_PPS take the RTC alarm or the pin's GPIO IRQ
+ * and can be used by one instance at a time. Returns VFD_ERR_UNSUPPORTED
+ * on the PIO backend, and for those two sources on a host build.
+ */
+vfd_error_t vfd_clock_start(const vfd_clock_config_t *config);
+
+/**
+ * Set the time of day (24 h) the clock shows
+ * Call it on a second boundary: the timer source ticks one second after
+ * the call, a PPS source at its next edge. With VFD_CLOCK_RTC it sets the
+ * RTC's time and keeps its date. May be called before vfd_clock_start();
+ * an RTC clock then sets the RTC from it when it starts.
+ */
+vfd_error_t vfd_clock_set_time(uint8_t hours, uint8_t minutes, uint8_t seconds);
+
+/**
+ * Stop the clock and release its source; the face goes at the next frame boundary
+ */
+vfd_error_t vfd_clock_stop(void);
+
+/* Animation */
+
+/**
+ * Play a sequence of precomputed frames
+ * Each frame is encoded once, on an alarm when it comes due, into a stage
+ * buffer that the scan engine switches to at its next frame boundary. On
+ * the PIO backend that is the DMA read address alone, so frames play with
+ * no CPU per scan. The animation covers the first chip's grids; other
+ * chips of a chain and the brightness levels come from the last commit.
+ *
+ * While it plays, commits are kept but not shown. A one-shot animation
+ * holds its last frame for its hold time, then the committed frame returns
+ * and on_done (may be NULL) runs from the alarm IRQ. Playing again
+ * replaces a running animation. The animation must stay valid while it
+ * plays. Uses one alarm from the default alarm pool.
+ */
+vfd_error_t vfd_play_animation(const vfd_animation_t *animation, vfd_anim_callback_t on_done,
+                               void *user_data);
+
+/**
+ * Stop the animation or transition and show the committed frame again (no callback)
+ */
+vfd_error_t vfd_stop_animation(void);
+
+/**
+ * Check if an animation or a transition is playing
+ */
+bool vfd_is_animation_playing(void);
+
+/* Transitions */
+
+/**
+ * Commit the back buffer, changing over to it over duration_ms
+ * The animation player renders each intermediate stage from the frame
+ * shown so far and the commit, encodes it when it comes due and hands it
+ * to the scan engine at a frame boundary; the caller spends nothing per
+ * stage. Once the last stage has held, the commit itself shows.
+ *
+ * FADE splits each changed grid's slot between its old and new words, one
+ * stage per frame of the duration (2 to 32); dimmed grids fade out and
+ * back in instead, as their blank part must stay blank. ROLL rolls changed digits
+ * up in three stages. SLIDE and WIPE take one stage per grid of the tube.
+ * Brightness and command bits follow the commit from the start, and a
+ * commit made meanwhile becomes the new target. Replaces a running
+ * animation or transition, and is replaced by the next one, without
+ * either calling on_done. CUT or a duration of 0 is a plain vfd_commit().
+ */
+vfd_error_t vfd_transition(vfd_transition_t type, uint32_t duration_ms);
+
 /* Buffer Management */
 
 /**
- * Get pointer to display buffer for direct manipulation
- * Changes applied after vfd_refresh()
+ * Get pointer to the back buffer for direct manipulation
+ * Changes applied after vfd_commit() or vfd_refresh()
+ * The back buffer moves on every commit, so fetch the pointer again after
+ * each one. Direct edits cannot be tracked; the next commit re-encodes the
+ * whole frame. With a chain, index the result per chip: vfd_get_buffer()[n].
  */
 vfd_display_buffer_t *vfd_get_buffer(void);
 
@@ -139,6 +843,51 @@ vfd_display_buffer_t *vfd_get_buffer(void);
  */
 vfd_error_t vfd_fill_buffer(uint8_t segments);
 
+/* Autonomous Refresh */
+
+/**
+ * Start background refresh
+ * An alarm steps one grid every refresh_interval_us straight from
+ * the front buffer's cached words, so the tube stays lit with no further
+ * calls. Uses one alarm from the default alarm pool.
+ *
+ * With VFD_BACKEND_PIO, two DMA channels instead stream the encoded frame
+ * into the state machine forever, with no CPU or interrupt load per frame.
+ * Writes become visible at the frame boundary after vfd_commit() (or
+ * vfd_refresh(), which only commits while autorefresh runs).
+ */
+vfd_error_t vfd_start_autorefresh(void);
+
+/**
+ * Hand the MAX6921 to core 1
+ * Core 1 runs the scan-out loop against absolute deadlines and owns the SPI
+ * port, so display timing is unaffected by interrupt load on core 0. Core 0
+ * keeps writing the back buffer and committing as usual; control commands
+ * travel over the SIO FIFO. Requires VFD_BACKEND_SPI, and core 1 and the
+ * multicore FIFO must not be used by the application while running.
+ * Returns VFD_ERR_BUSY if another refresh engine is running.
+ */
+vfd_error_t vfd_launch_core1(void);
+
+/**
+ * Stop background refresh (timer, DMA or core 1) and blank the display
+ */
+vfd_error_t vfd_stop_autorefresh(void);
+
+/**
+ * Check if background refresh (any engine) is running
+ */
+bool vfd_is_autorefresh_running(void);
+
+/**
+ * Check if the system may go dormant
+ * True while the timer or core 1 engine is parked: config.low_power is set
+ * and the display has been blank and static for idle_after_ms, so the tube
+ * is blanked and the engine needs no alarm or clock. The next commit (or
+ * marquee, clock or animation start) wakes it.
+ */
+bool vfd_is_dormant_ready(void);
+
 /* Custom Commands */
 
 /**
@@ -157,13 +906,50 @@ typedef struct {
     uint8_t command;               /* Custom command code (0-7) */
 } vfd_control_command_t;
 
+/* Set in vfd_t.queued_command while a queued command waits for its step */
+#define VFD_COMMAND_QUEUED 0x80
+
+/**
+ * Hold command bits 19-17 through a grid's slot
+ * The bits ride in the grid's own lit and blank words, so they cost no bus
+ * time and never blank the tube. Chained chips each have their own bits,
+ * addressed like segments. Like any write it takes effect on the next
+ * commit, and it is cached in the frame until changed.
+ */
+vfd_error_t vfd_set_grid_command(uint8_t grid, uint8_t command);
+
+/**
+ * Hold the same command bits through every grid of the frame
+ */
+vfd_error_t vfd_set_command(uint8_t command);
+
+/**
+ * OR command bits into the next scan step only
+ * The bits go out with that step's lit and blank words, on top of the
+ * grid's own. Returns VFD_ERR_BUSY while the previous one is still
+ * waiting, and while the PIO backend's DMA streams frames on its own.
+ */
+vfd_error_t vfd_queue_command(uint8_t command);
+
 /**
  * Send a custom command
  * Command is encoded in bits 19-17 and sent via SPI as part of a 3-byte transmission.
  * Can be sent standalone (with grid/segment bits = 0) or combined with display data.
+ * While autorefresh or core 1 is running the command is queued and sent in
+ * place of the next grid step; returns VFD_ERR_BUSY if the queue is full, and
+ * always on the PIO backend since DMA owns the state machine.
  */
 vfd_error_t vfd_send_control_command(const vfd_control_command_t *cmd);
 
+/**
+ * Send a custom command without waiting for the bus
+ * The standalone word goes out by DMA and is latched from the completion
+ * IRQ, which then calls on_done (may be NULL). Same errors as
+ * vfd_refresh_async().
+ */
+vfd_error_t vfd_send_control_command_async(const vfd_control_command_t *cmd,
+                                           vfd_async_callback_t on_done, void *user_data);
+
 /* Utility Functions */
 
 /**
@@ -173,11 +959,172 @@ vfd_error_t vfd_send_control_command(const vfd_control_command_t *cmd);
  */
 int vfd_segments_to_string(uint8_t segments, char *buffer, int buffer_size);
 
+/**
+ * Segment pattern for a character
+ * Digits, letters (A b C d E F H L o P r t U ...), and - _ = " ' ` ^ ~ [ ]
+ * ( ) | / \ ? ! , * and the Latin-1 degree sign (0xB0); anything else is
+ * blank. Both letter cases are accepted.
+ */
+uint8_t vfd_char_to_segments(char c);
+
 /**
  * Get descriptive error message
  */
 const char *vfd_strerror(vfd_error_t error);
 
+/* Timing Statistics */
+
+/**
+ * Refresh timing snapshot, all times in microseconds (time_us_64())
+ * frame_us: grid 0 to grid 0 of the next frame (one whole blocking refresh)
+ * dwell_us: one grid step to the next, including its blank word and any
+ *           control command sent in between
+ * spi_us:   one SPI burst plus latch pulse
+ * missed_deadlines: timer or core 1 steps that finished after the next step
+ *           was already due
+ * frames_late: with a target_fps, frames more than 1% longer than
+ *           target_frame_us
+ * Averages are 0 until the first sample. The PIO + DMA engine scans with no
+ * CPU involvement and is not measured.
+ */
+typedef struct {
+    uint32_t frames;               /* Complete frames sent */
+    uint32_t frame_us_min;
+    uint32_t frame_us_avg;
+    uint32_t frame_us_max;
+    uint32_t dwell_us_min;
+    uint32_t dwell_us_avg;
+    uint32_t dwell_us_max;
+    uint32_t grid_dwell_us_avg[VFD_GRIDS_MAX]; /* Average dwell of each scan step */
+    uint32_t spi_us_min;
+    uint32_t spi_us_avg;
+    uint32_t spi_us_max;
+    uint32_t missed_deadlines;
+    uint32_t target_frame_us;      /* 1 s / target_fps, 0 without a target */
+    uint32_t frames_late;
+} vfd_stats_t;
+
+/**
+ * Get a consistent copy of the timing statistics
+ * Safe to call from either core while any engine runs. Returns
+ * VFD_ERR_UNSUPPORTED unless the build defines MAX6921_STATS=1; without it
+ * no timing code is compiled into the scan paths at all.
+ */
+vfd_error_t vfd_get_stats(vfd_stats_t *stats);
+
+/**
+ * Clear the timing statistics
+ * With an engine running, the engine clears them at its next grid step.
+ */
+vfd_error_t vfd_reset_stats(void);
+
+/* Trace Recorder */
+
+/* Receives the dump one line at a time, without the newline */
+typedef void (*vfd_trace_print_t)(const char *line, void *user_data);
+
+/**
+ * Copy the newest trace entries, oldest first
+ * Every word shifted to the chain, latch edge and standalone command is
+ * recorded with a time_us_32() stamp, a few cycles each, into a ring of
+ * MAX6921_TRACE_SIZE entries. Safe from either core while any engine
+ * runs; entries overwritten during the copy are left out. *count gets
+ * the number copied, at most max_entries. Returns VFD_ERR_UNSUPPORTED
+ * unless the build defines MAX6921_TRACE=1. The PIO backend shifts its
+ * words without the CPU and is not traced.
+ */
+vfd_error_t vfd_get_trace(vfd_trace_entry_t *entries, uint32_t max_entries, uint32_t *count);
+
+/**
+ * Print the trace as "trace,<time_us>,<kind>,<chip>,<value>" lines, oldest first
+ * kind is word, latch or command, the value in hex; a "trace,end" line
+ * follows the last entry. host/trace_decode.c turns a dump back into
+ * what each grid showed.
+ */
+vfd_error_t vfd_dump_trace(vfd_trace_print_t print, void *user_data);
+
+/**
+ * Forget the entries recorded so far
+ */
+vfd_error_t vfd_reset_trace(void);
+
+/* Multiple Displays */
+
+/**
+ * Instance-based variants of the functions above
+ * Each takes the instance first and otherwise behaves exactly like its
+ * single-display counterpart, which is a wrapper over the default instance.
+ * Instances need distinct pins and, for VFD_BACKEND_SPI, distinct spi_index
+ * values. Only one instance at a time can run on core 1. Calls on a NULL or
+ * uninitialized instance return VFD_ERR_NOT_INITIALIZED.
+ */
+vfd_error_t vfd_init_ex(vfd_t *vfd, const vfd_config_t *config);
+bool vfd_is_initialized_ex(vfd_t *vfd);
+vfd_error_t vfd_deinit_ex(vfd_t *vfd);
+vfd_error_t vfd_calibrate_baudrate_ex(vfd_t *vfd, uint32_t max_baudrate);
+uint32_t vfd_get_baudrate_ex(vfd_t *vfd);
+vfd_error_t vfd_write_segments_ex(vfd_t *vfd, uint8_t grid, uint8_t segments);
+vfd_error_t vfd_read_segments_ex(vfd_t *vfd, uint8_t grid, uint8_t *segments);
+vfd_error_t vfd_write_digit_ex(vfd_t *vfd, uint8_t grid, uint8_t digit);
+vfd_error_t vfd_clear_ex(vfd_t *vfd);
+vfd_error_t vfd_refresh_ex(vfd_t *vfd);
+vfd_error_t vfd_refresh_async_ex(vfd_t *vfd, vfd_async_callback_t on_done, void *user_data);
+bool vfd_is_async_busy_ex(vfd_t *vfd);
+vfd_error_t vfd_commit_ex(vfd_t *vfd);
+vfd_error_t vfd_set_brightness_ex(vfd_t *vfd, uint8_t level);
+vfd_error_t vfd_set_grid_brightness_ex(vfd_t *vfd, uint8_t grid, uint8_t level);
+vfd_error_t vfd_write_string_ex(vfd_t *vfd, const char *str);
+vfd_error_t vfd_write_region_ex(vfd_t *vfd, uint8_t first_grid, uint8_t count,
+                                const uint8_t *patterns);
+vfd_error_t vfd_write_string_at_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width,
+                                   const char *str);
+vfd_error_t vfd_post_update_ex(vfd_t *vfd, const vfd_update_t *update);
+uint32_t vfd_get_update_overflows_ex(vfd_t *vfd);
+vfd_error_t vfd_write_int_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, int32_t value,
+                             vfd_align_t align);
+vfd_error_t vfd_write_fixed_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, int32_t value,
+                               uint8_t decimals, vfd_align_t align);
+vfd_error_t vfd_write_hex_ex(vfd_t *vfd, uint8_t first_grid, uint8_t width, uint32_t value,
+                             vfd_align_t align);
+vfd_error_t vfd_marquee_start_ex(vfd_t *vfd, const vfd_marquee_config_t *config,
+                                 const char *text);
+vfd_error_t vfd_marquee_append_ex(vfd_t *vfd, const char *text);
+vfd_error_t vfd_marquee_stop_ex(vfd_t *vfd);
+vfd_error_t vfd_clock_start_ex(vfd_t *vfd, const vfd_clock_config_t *config);
+vfd_error_t vfd_clock_set_time_ex(vfd_t *vfd, uint8_t hours, uint8_t minutes, uint8_t seconds);
+vfd_error_t vfd_clock_stop_ex(vfd_t *vfd);
+vfd_error_t vfd_play_animation_ex(vfd_t *vfd, const vfd_animation_t *animation,
+                                  vfd_anim_callback_t on_done, void *user_data);
+vfd_error_t vfd_stop_animation_ex(vfd_t *vfd);
+bool vfd_is_animation_playing_ex(vfd_t *vfd);
+vfd_error_t vfd_transition_ex(vfd_t *vfd, vfd_transition_t type, uint32_t duration_ms);
+vfd_display_buffer_t *vfd_get_buffer_ex(vfd_t *vfd);
+vfd_error_t vfd_fill_buffer_ex(vfd_t *vfd, uint8_t segments);
+vfd_error_t vfd_set_grid_command_ex(vfd_t *vfd, uint8_t grid, uint8_t command);
+vfd_error_t vfd_set_command_ex(vfd_t *vfd, uint8_t command);
+vfd_error_t vfd_queue_command_ex(vfd_t *vfd, uint8_t command);
+vfd_error_t vfd_send_control_command_ex(vfd_t *vfd, const vfd_control_command_t *cmd);
+vfd_error_t vfd_send_control_command_async_ex(vfd_t *vfd, const vfd_control_command_t *cmd,
+                                              vfd_async_callback_t on_done, void *user_data);
+vfd_error_t vfd_start_autorefresh_ex(vfd_t *vfd);
+vfd_error_t vfd_launch_core1_ex(vfd_t *vfd);
+vfd_error_t vfd_stop_autorefresh_ex(vfd_t *vfd);
+bool vfd_is_autorefresh_running_ex(vfd_t *vfd);
+bool vfd_is_dormant_ready_ex(vfd_t *vfd);
+vfd_error_t vfd_get_stats_ex(vfd_t *vfd, vfd_stats_t *stats);
+vfd_error_t vfd_reset_stats_ex(vfd_t *vfd);
+vfd_error_t vfd_get_trace_ex(vfd_t *vfd, vfd_trace_entry_t *entries, uint32_t max_entries,
+                             uint32_t *count);
+vfd_error_t vfd_dump_trace_ex(vfd_t *vfd, vfd_trace_print_t print, void *user_data);
+vfd_error_t vfd_reset_trace_ex(vfd_t *vfd);
+
+/**
+ * Get the instance used by the single-display functions
+ * Lets code mix both styles, e.g. pass the default display to a helper
+ * written against the *_ex API.
+ */
+vfd_t *vfd_default_instance(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,263 @@
+/**
+ * @file max6921.hpp
+ * @brief Header-only C++20 front-end with the board fixed at compile time
+ *
+ * Vfd<SpiIndex, Pins, Grids, SegmentMap, GridsPerChip> wraps one driver instance for a
+ * board whose SPI block, pins, tube size and segment wiring never change.
+ * Those are checked once, by the compiler; text and animation frames
+ * written as literals are encoded by consteval builders into const tables,
+ * and the write paths store straight into the back buffer with no runtime
+ * checks. The segment wiring becomes part of the driver's output map, so
+ * everything else is the C API on the wrapped instance, rendering alike.
+ *
+ *     using Board = max6921::Vfd<1, max6921::Pins{}, 9>;
+ *     static constexpr Board::Patterns hello = Board::text("HELLO");
+ *     static Board vfd;
+ *
+ *     vfd.init();
+ *     vfd.write(hello);
+ *     vfd.commit();
+ */
+
+#ifndef MAX6921_HPP
+#define MAX6921_HPP
+
+#if __cplusplus < 202002L
+#error "max6921.hpp needs C++20 (consteval, class-type template parameters)"
+#endif
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "max6921.h"
+#include "max6921_font.h"
+
+namespace max6921 {
+
+/* Board pins; the defaults match vfd_default_config() */
+struct Pins {
+    uint8_t tx = 11;
+    uint8_t clk = 10;
+    uint8_t latch = 13;
+    uint8_t rx = 12;               /* Only used by vfd_calibrate_baudrate() */
+};
+
+/* Segment output that each font segment (A=0 .. G=6, DP=7) is wired to,
+ * numbered as the default wiring's segments; init() folds it into the
+ * config's output_map */
+struct SegmentMap {
+    uint8_t bit[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+
+    constexpr bool identity() const {
+        for (uint8_t i = 0; i < 8; i++) {
+            if (bit[i] != i) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* Every segment on an output of its own */
+    constexpr bool valid() const {
+        uint8_t seen = 0;
+        for (uint8_t i = 0; i < 8; i++) {
+            if (bit[i] > 7 || (seen & (1u << bit[i]))) {
+                return false;
+            }
+            seen = static_cast<uint8_t>(seen | (1u << bit[i]));
+        }
+        return true;
+    }
+};
+
+/* The driver's font, as a constant expression */
+constexpr uint8_t glyph(char c) {
+    switch (static_cast<uint8_t>(c)) {
+#define MAX6921_GLYPH_CASE(code, segments) \
+    case static_cast<uint8_t>(code): return static_cast<uint8_t>(segments);
+    MAX6921_FONT(MAX6921_GLYPH_CASE)
+#undef MAX6921_GLYPH_CASE
+    default:
+        return VFD_BLANK;
+    }
+}
+
+/* Lay text out over N grids by the rules of vfd_write_string(): a '.'
+ * after a character lights its decimal point, unused grids are blank */
+template <std::size_t N>
+constexpr std::array<uint8_t, N> render(const char *str) {
+    std::array<uint8_t, N> out{};
+    std::size_t grid = 0;
+    bool can_fold = false;
+
+    for (const char *p = str; *p != '\0'; p++) {
+        char c = *p;
+        if (c == '.' && can_fold) {
+            out[grid - 1] |= VFD_SYMBOL_DOT;
+            can_fold = false;
+            continue;
+        }
+        if (grid >= N) {
+            break;
+        }
+        out[grid++] = glyph(c);
+        can_fold = (c != '.');
+    }
+    return out;
+}
+
+namespace detail {
+
+/* Store a pattern in the back buffer without any checks, with the
+ * driver's change-only dirty tracking; for the write paths, whose grid
+ * range the compiler has checked */
+inline void store_segments(vfd_t *vfd, uint8_t grid, uint8_t segments) {
+    uint8_t step = vfd->grid_slot[grid] & 0x0F;
+    uint8_t *slot = &vfd->frames[vfd->back].segments[vfd->grid_slot[grid] >> 4][step];
+    if (*slot != segments) {
+        *slot = segments;
+        vfd->dirty |= static_cast<uint16_t>(1u << step);
+    }
+}
+
+} /* namespace detail */
+
+/**
+ * One display on a fixed board
+ * SpiIndex and Board must name SPI pins of the same block; Grids is the
+ * tube size across the chain, GridsPerChip what each chip scans. Patterns
+ * are in font order, as for the C API; init() applies Map to the wiring,
+ * on top of any output_map in the config it is given.
+ * Call init() first; the write paths rely on it and check nothing.
+ */
+template <uint8_t SpiIndex, Pins Board = Pins{}, uint8_t Grids = 9, SegmentMap Map = SegmentMap{},
+          uint8_t GridsPerChip = 9>
+class Vfd {
+    static_assert(SpiIndex <= 1, "spi0 or spi1");
+    static_assert(GridsPerChip >= 1 && GridsPerChip <= VFD_GRIDS_MAX,
+                  "1 to VFD_GRIDS_MAX grids per chip");
+    static_assert(Grids >= 1 && Grids <= GridsPerChip * VFD_CHAIN_MAX,
+                  "1 to GridsPerChip * VFD_CHAIN_MAX grids");
+    static_assert(Map.valid(), "SegmentMap must put each segment on an output of its own");
+    /* RP2040 SPI pins repeat every four GPIOs, the block alternating per bank of eight */
+    static_assert(Board.tx % 4 == 3 && ((Board.tx / 8) & 1) == SpiIndex,
+                  "tx is not a TX pin of this SPI block");
+    static_assert(Board.clk % 4 == 2 && ((Board.clk / 8) & 1) == SpiIndex,
+                  "clk is not an SCK pin of this SPI block");
+
+public:
+    using Patterns = std::array<uint8_t, Grids>;
+    static constexpr uint8_t chain_length = (Grids + GridsPerChip - 1) / GridsPerChip;
+
+    static consteval uint8_t glyph(char c) {
+        return max6921::glyph(c);
+    }
+
+    static consteval Patterns text(const char *str) {
+        return render<Grids>(str);
+    }
+
+    /* Animation frame for the first chip's grids, for const animation tables */
+    static consteval vfd_anim_frame_t frame(const char *str, uint16_t hold_ms) {
+        std::array<uint8_t, GridsPerChip> patterns = render<GridsPerChip>(str);
+        vfd_anim_frame_t f{};
+        for (std::size_t i = 0; i < GridsPerChip; i++) {
+            f.segments[i] = patterns[i];
+        }
+        f.hold_ms = hold_ms;
+        return f;
+    }
+
+    template <std::size_t N>
+    static consteval std::array<vfd_anim_frame_t, N> frames(const char *const (&texts)[N],
+                                                             uint16_t hold_ms) {
+        std::array<vfd_anim_frame_t, N> out{};
+        for (std::size_t i = 0; i < N; i++) {
+            out[i] = frame(texts[i], hold_ms);
+        }
+        return out;
+    }
+
+    template <std::size_t N>
+    static constexpr vfd_animation_t animation(const std::array<vfd_anim_frame_t, N> &frames,
+                                               bool loop) {
+        static_assert(N >= 1 && N <= UINT16_MAX, "1 to 65535 frames");
+        return vfd_animation_t{frames.data(), static_cast<uint16_t>(N), loop};
+    }
+
+    /* Bring the driver up with this board's SPI block, pins, tube size,
+     * chain and segment wiring; everything else comes from base, e.g.
+     * target_fps or latch */
+    vfd_error_t init(vfd_config_t base = vfd_default_config()) {
+        base.backend = VFD_BACKEND_SPI;
+        base.spi_index = SpiIndex;
+        base.pin_spi_tx = Board.tx;
+        base.pin_spi_clk = Board.clk;
+        base.pin_latch = Board.latch;
+        base.pin_spi_rx = Board.rx;
+        base.grids = GridsPerChip;
+        base.chain_length = chain_length;
+
+        /* Read by init only, so the wiring can live on the stack */
+        vfd_output_map_t wiring = (base.output_map != nullptr)
+                                      ? *base.output_map
+                                      : vfd_default_output_map(GridsPerChip);
+        if constexpr (!Map.identity()) {
+            uint8_t segment[8];
+            for (uint8_t i = 0; i < 8; i++) {
+                segment[i] = wiring.segment[Map.bit[i]];
+            }
+            for (uint8_t i = 0; i < 8; i++) {
+                wiring.segment[i] = segment[i];
+            }
+        }
+        base.output_map = &wiring;
+        return vfd_init_ex(&vfd_, &base);
+    }
+
+    vfd_error_t deinit() { return vfd_deinit_ex(&vfd_); }
+
+    template <uint8_t Grid>
+    void write(uint8_t segments) {
+        static_assert(Grid < Grids, "grid out of range");
+        detail::store_segments(&vfd_, Grid, segments);
+    }
+
+    template <uint8_t First, std::size_t N>
+    void write(const std::array<uint8_t, N> &patterns) {
+        static_assert(First + N <= Grids, "region out of range");
+        for (std::size_t i = 0; i < N; i++) {
+            detail::store_segments(&vfd_, static_cast<uint8_t>(First + i), patterns[i]);
+        }
+    }
+
+    void write(const Patterns &patterns) { write<0>(patterns); }
+
+    /* Text known only at run time, laid out like text() */
+    void print(const char *str) { write(render<Grids>(str)); }
+
+    vfd_error_t commit() { return vfd_commit_ex(&vfd_); }
+    vfd_error_t refresh() { return vfd_refresh_ex(&vfd_); }
+    vfd_error_t set_brightness(uint8_t level) { return vfd_set_brightness_ex(&vfd_, level); }
+    vfd_error_t start_autorefresh() { return vfd_start_autorefresh_ex(&vfd_); }
+    vfd_error_t stop_autorefresh() { return vfd_stop_autorefresh_ex(&vfd_); }
+
+    vfd_error_t play(const vfd_animation_t &animation, vfd_anim_callback_t on_done = nullptr,
+                     void *user_data = nullptr) {
+        return vfd_play_animation_ex(&vfd_, &animation, on_done, user_data);
+    }
+
+    vfd_error_t transition(vfd_transition_t type, uint32_t duration_ms) {
+        return vfd_transition_ex(&vfd_, type, duration_ms);
+    }
+
+    /* The wrapped instance, for the rest of the *_ex API */
+    vfd_t *handle() { return &vfd_; }
+
+private:
+    vfd_t vfd_{};
+};
+
+} /* namespace max6921 */
+
+#endif /* MAX6921_HPP */
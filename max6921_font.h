@@ -0,0 +1,44 @@
+/**
+ * @file max6921_font.h
+ * @brief ASCII / Latin-1 to 7-segment font, as an X-macro list
+ *
+ * MAX6921_FONT(X) expands X(code, segments) once per character that has a
+ * glyph; every other code is blank. The C driver builds its lookup table
+ * from it and max6921.hpp its compile-time encoder, so both render text
+ * identically. Bits follow the segment layout: A=0 B=1 C=2 D=3 E=4 F=5
+ * G=6 H(DP)=7. Letters without a readable capital use the lowercase form
+ * (b, d, n, o, r, t, u) and vice versa. Needs the VFD_DIGIT_* and
+ * VFD_SYMBOL_* values from max6921.h.
+ */
+
+#ifndef MAX6921_FONT_H
+#define MAX6921_FONT_H
+
+#define MAX6921_FONT(X) \
+    X('0', VFD_DIGIT_0) X('1', VFD_DIGIT_1) X('2', VFD_DIGIT_2) \
+    X('3', VFD_DIGIT_3) X('4', VFD_DIGIT_4) X('5', VFD_DIGIT_5) \
+    X('6', VFD_DIGIT_6) X('7', VFD_DIGIT_7) X('8', VFD_DIGIT_8) \
+    X('9', VFD_DIGIT_9) \
+    \
+    X('A', 0x77) X('B', 0x7C) X('C', 0x39) X('D', 0x5E) X('E', 0x79) \
+    X('F', 0x71) X('G', 0x3D) X('H', 0x76) X('I', 0x30) X('J', 0x1E) \
+    X('K', 0x75) X('L', 0x38) X('M', 0x15) X('N', 0x37) X('O', 0x3F) \
+    X('P', 0x73) X('Q', 0x67) X('R', 0x50) X('S', 0x6D) X('T', 0x78) \
+    X('U', 0x3E) X('V', 0x3E) X('W', 0x2A) X('X', 0x76) X('Y', 0x6E) \
+    X('Z', 0x5B) \
+    \
+    X('a', 0x5F) X('b', 0x7C) X('c', 0x58) X('d', 0x5E) X('e', 0x7B) \
+    X('f', 0x71) X('g', 0x6F) X('h', 0x74) X('i', 0x10) X('j', 0x0E) \
+    X('k', 0x75) X('l', 0x30) X('m', 0x15) X('n', 0x54) X('o', 0x5C) \
+    X('p', 0x73) X('q', 0x67) X('r', 0x50) X('s', 0x6D) X('t', 0x78) \
+    X('u', 0x1C) X('v', 0x1C) X('w', 0x2A) X('x', 0x76) X('y', 0x6E) \
+    X('z', 0x5B) \
+    \
+    X('-', VFD_SYMBOL_DASH) X('_', 0x08) X('=', 0x48) X('"', 0x22) \
+    X('\'', 0x20) X('`', 0x02) X('^', 0x23) X('~', 0x01) \
+    X('[', 0x39) X(']', 0x0F) X('(', 0x39) X(')', 0x0F) X('|', 0x30) \
+    X('/', 0x52) X('\\', 0x64) X('?', 0x53) X('!', 0x82) \
+    X('.', VFD_SYMBOL_DOT) X(',', 0x0C) X('*', 0x63) \
+    X(0xB0, 0x63)                  /* Degree sign (Latin-1) */
+
+#endif /* MAX6921_FONT_H */
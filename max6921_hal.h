@@ -0,0 +1,128 @@
+/**
+ * @file max6921_hal.h
+ * @brief Hardware access used by the MAX6921 driver's SPI path
+ *
+ * The driver reaches the SPI block, the latch GPIO and the clock only
+ * through these calls. On the Pico they are inline wrappers over the SDK
+ * (max6921_hal_pico.h), so they cost nothing over calling the SDK directly.
+ * Building with MAX6921_HOST=1 leaves them as plain functions for a host
+ * implementation such as the simulator in host/, and compiles out the
+ * PIO, DMA and core 1 engines, which have no host equivalent.
+ */
+
+#ifndef MAX6921_HAL_H
+#define MAX6921_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef MAX6921_HOST
+#define MAX6921_HOST 0             /* 1: build against a host HAL, not the Pico SDK */
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Alarm callback: return <0 to re-arm relative to the due time, >0 relative
+ * to now, 0 to stop (same contract as the SDK's alarm pool) */
+typedef int64_t (*max6921_hal_alarm_callback_t)(int32_t id, void *user_data);
+
+/* Non-blocking SPI write completion, called from an IRQ */
+typedef void (*max6921_hal_spi_done_t)(void *user_data);
+
+#if MAX6921_HOST
+
+/**
+ * Bring up SPI block spi_index on the given pins, 8-bit MSB-first mode 0
+ * Returns the baud rate actually set, 0 on failure
+ */
+uint32_t max6921_hal_spi_init(uint8_t spi_index, uint32_t baudrate,
+                              uint8_t pin_tx, uint8_t pin_clk);
+
+/**
+ * As above, but in 16-bit MSB-first mode 3 with pin_cs as the block's CSn
+ * CSn stays low while the FIFO has data and rises after the last bit, so
+ * wired to LOAD it latches each write without software. Writes must then
+ * be a whole number of frames (even len) that fit the 8-frame FIFO.
+ */
+uint32_t max6921_hal_spi_init_latched(uint8_t spi_index, uint32_t baudrate,
+                                      uint8_t pin_tx, uint8_t pin_clk, uint8_t pin_cs);
+void max6921_hal_spi_deinit(uint8_t spi_index);
+
+/**
+ * Change the clock of a running block; returns the rate actually set
+ */
+uint32_t max6921_hal_spi_set_baudrate(uint8_t spi_index, uint32_t baudrate);
+
+/**
+ * Route pin_rx to the block's RX, for reading the chain's DOUT back
+ */
+void max6921_hal_spi_init_rx(uint8_t spi_index, uint8_t pin_rx);
+
+/**
+ * Shift len bytes out and return once the last bit has left the pin
+ */
+void max6921_hal_spi_write(uint8_t spi_index, const uint8_t *data, size_t len);
+
+/**
+ * Shift len bytes out while reading as many in, with IRQs held off so
+ * the FIFO never runs dry (any length, even with a CSn latch)
+ */
+void max6921_hal_spi_transfer(uint8_t spi_index, const uint8_t *tx, uint8_t *rx, size_t len);
+
+/**
+ * Claim what non-blocking writes on spi_index need (two DMA channels on the
+ * Pico); false if that is not available. Deinit gives it back.
+ */
+bool max6921_hal_spi_async_init(uint8_t spi_index);
+void max6921_hal_spi_async_deinit(uint8_t spi_index);
+
+/**
+ * Start shifting len bytes out and return at once
+ * done runs from an IRQ once the last bit has left the pin. data must stay
+ * valid until then, and only one write per SPI block may be in flight.
+ */
+void max6921_hal_spi_write_async(uint8_t spi_index, const uint8_t *data, size_t len,
+                                 max6921_hal_spi_done_t done, void *user_data);
+
+void max6921_hal_gpio_init_output(uint8_t pin);
+void max6921_hal_gpio_put(uint8_t pin, bool value);
+
+/**
+ * Delays: sleep may yield to other work, busy wait must be IRQ-safe
+ */
+void max6921_hal_sleep_us(uint32_t us);
+void max6921_hal_sleep_until(uint64_t time_us);
+void max6921_hal_busy_wait_us(uint32_t us);
+
+/**
+ * Microseconds since boot, in full and wrapping at 32 bits (one register read on the Pico)
+ */
+uint64_t max6921_hal_time_us(void);
+uint32_t max6921_hal_time_us_32(void);
+
+/**
+ * One-shot alarm at an absolute time; returns an id > 0, or <= 0 on failure
+ */
+int32_t max6921_hal_alarm_at(uint64_t time_us, max6921_hal_alarm_callback_t callback,
+                             void *user_data);
+void max6921_hal_alarm_cancel(int32_t id);
+
+/* SDK helpers the portable part of the driver relies on */
+#define __dmb() __sync_synchronize()
+#define tight_loop_contents() ((void)0)
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#else
+
+#include "max6921_hal_pico.h"
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAX6921_HAL_H */
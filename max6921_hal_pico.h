@@ -0,0 +1,278 @@
+/**
+ * @file max6921_hal_pico.h
+ * @brief Pico SDK implementation of the MAX6921 HAL
+ *
+ * Included by max6921_hal.h; do not include directly.
+ */
+
+#ifndef MAX6921_HAL_PICO_H
+#define MAX6921_HAL_PICO_H
+
+#include "pico/stdlib.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+static inline spi_inst_t *max6921_hal_spi_port(uint8_t spi_index) {
+    return (spi_index == 0) ? spi0 : spi1;
+}
+
+/* Blocks set up by max6921_hal_spi_init_latched() move 16-bit frames */
+static bool max6921_hal_spi_wide[2];
+
+static inline uint32_t max6921_hal_spi_init(uint8_t spi_index, uint32_t baudrate,
+                                            uint8_t pin_tx, uint8_t pin_clk) {
+    uint actual_baudrate = spi_init(max6921_hal_spi_port(spi_index), baudrate);
+    if (actual_baudrate == 0) {
+        return 0;
+    }
+
+    gpio_set_function(pin_clk, GPIO_FUNC_SPI);
+    gpio_set_function(pin_tx, GPIO_FUNC_SPI);
+    max6921_hal_spi_wide[spi_index] = false;
+    return actual_baudrate;
+}
+
+static inline uint32_t max6921_hal_spi_init_latched(uint8_t spi_index, uint32_t baudrate,
+                                                    uint8_t pin_tx, uint8_t pin_clk,
+                                                    uint8_t pin_cs) {
+    uint32_t actual_baudrate = max6921_hal_spi_init(spi_index, baudrate, pin_tx, pin_clk);
+    if (actual_baudrate == 0) {
+        return 0;
+    }
+
+    /* With SPH=0 the PL022 pulses CSn between frames, which would latch a
+     * half-shifted word; SPH=1 holds it low until the FIFO runs dry. CPOL=1
+     * keeps data changing on the falling edge, as the MAX6921 samples on
+     * the rising one. */
+    spi_set_format(max6921_hal_spi_port(spi_index), 16, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+    gpio_set_function(pin_cs, GPIO_FUNC_SPI);
+    max6921_hal_spi_wide[spi_index] = true;
+    return actual_baudrate;
+}
+
+static inline void max6921_hal_spi_deinit(uint8_t spi_index) {
+    spi_deinit(max6921_hal_spi_port(spi_index));
+}
+
+static inline uint32_t max6921_hal_spi_set_baudrate(uint8_t spi_index, uint32_t baudrate) {
+    return spi_set_baudrate(max6921_hal_spi_port(spi_index), baudrate);
+}
+
+static inline void max6921_hal_spi_init_rx(uint8_t spi_index, uint8_t pin_rx) {
+    (void)spi_index;
+    gpio_set_function(pin_rx, GPIO_FUNC_SPI);
+}
+
+static inline void max6921_hal_spi_write(uint8_t spi_index, const uint8_t *data, size_t len) {
+    spi_inst_t *spi = max6921_hal_spi_port(spi_index);
+    if (!max6921_hal_spi_wide[spi_index]) {
+        spi_write_blocking(spi, data, len);
+        return;
+    }
+
+    /* The whole burst goes into the FIFO at once: an interrupt between two
+     * frames could let it run dry and raise CSn early */
+    uint32_t status = save_and_disable_interrupts();
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        spi_get_hw(spi)->dr = ((uint32_t)data[i] << 8) | data[i + 1];
+    }
+    restore_interrupts(status);
+
+    while (spi_is_busy(spi)) {
+        tight_loop_contents();
+    }
+    while (spi_is_readable(spi)) {
+        (void)spi_get_hw(spi)->dr;
+    }
+    spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
+static inline void max6921_hal_spi_transfer(uint8_t spi_index, const uint8_t *tx, uint8_t *rx,
+                                            size_t len) {
+    spi_inst_t *spi = max6921_hal_spi_port(spi_index);
+    bool wide = max6921_hal_spi_wide[spi_index];
+    size_t count = wide ? len / 2 : len;
+    size_t sent = 0;
+    size_t received = 0;
+
+    /* Keep at most a FIFO's worth in flight so RX cannot overrun */
+    uint32_t status = save_and_disable_interrupts();
+    while (received < count) {
+        if (sent < count && sent - received < 8 && spi_is_writable(spi)) {
+            spi_get_hw(spi)->dr = wide ? ((uint32_t)tx[2 * sent] << 8) | tx[2 * sent + 1]
+                                       : tx[sent];
+            sent++;
+        }
+        if (spi_is_readable(spi)) {
+            uint32_t frame = spi_get_hw(spi)->dr;
+            if (wide) {
+                rx[2 * received] = (uint8_t)(frame >> 8);
+                rx[2 * received + 1] = (uint8_t)frame;
+            } else {
+                rx[received] = (uint8_t)frame;
+            }
+            received++;
+        }
+    }
+    restore_interrupts(status);
+}
+
+/* Non-blocking writes: TX DMA feeds the FIFO and RX DMA drains it, so the
+ * RX channel finishes only once the last bit is clocked out, which is what
+ * the latch has to wait for. Its completion raises DMA_IRQ_1, shared with
+ * the application. Only the driver includes this header, so the state
+ * below exists once.
+ */
+typedef struct {
+    int tx_chan;
+    int rx_chan;
+    max6921_hal_spi_done_t done;
+    void *user_data;
+    uint16_t sink;
+    bool wide;
+} max6921_hal_spi_async_t;
+
+static max6921_hal_spi_async_t max6921_hal_spi_async[2] = {
+    {.tx_chan = -1, .rx_chan = -1},
+    {.tx_chan = -1, .rx_chan = -1},
+};
+
+static void max6921_hal_spi_dma_irq(void) {
+    for (uint8_t i = 0; i < 2; i++) {
+        max6921_hal_spi_async_t *a = &max6921_hal_spi_async[i];
+        if (a->rx_chan >= 0 && dma_channel_get_irq1_status((uint)a->rx_chan)) {
+            dma_channel_acknowledge_irq1((uint)a->rx_chan);
+            a->done(a->user_data);
+        }
+    }
+}
+
+static inline bool max6921_hal_spi_async_init(uint8_t spi_index) {
+    max6921_hal_spi_async_t *a = &max6921_hal_spi_async[spi_index];
+    if (a->rx_chan >= 0) {
+        return true;
+    }
+
+    int tx_chan = dma_claim_unused_channel(false);
+    int rx_chan = dma_claim_unused_channel(false);
+    if (tx_chan < 0 || rx_chan < 0) {
+        if (tx_chan >= 0) {
+            dma_channel_unclaim((uint)tx_chan);
+        }
+        if (rx_chan >= 0) {
+            dma_channel_unclaim((uint)rx_chan);
+        }
+        return false;
+    }
+
+    /* 16-bit frames are read from the byte buffer with the halves
+     * swapped, so the first byte still goes out first */
+    spi_inst_t *spi = max6921_hal_spi_port(spi_index);
+    bool wide = max6921_hal_spi_wide[spi_index];
+    enum dma_channel_transfer_size size = wide ? DMA_SIZE_16 : DMA_SIZE_8;
+    dma_channel_config tc = dma_channel_get_default_config((uint)tx_chan);
+    channel_config_set_transfer_data_size(&tc, size);
+    channel_config_set_bswap(&tc, wide);
+    channel_config_set_dreq(&tc, spi_get_dreq(spi, true));
+    dma_channel_configure((uint)tx_chan, &tc, &spi_get_hw(spi)->dr, NULL, 0, false);
+
+    dma_channel_config rc = dma_channel_get_default_config((uint)rx_chan);
+    channel_config_set_transfer_data_size(&rc, size);
+    channel_config_set_read_increment(&rc, false);
+    channel_config_set_write_increment(&rc, false);
+    channel_config_set_dreq(&rc, spi_get_dreq(spi, false));
+    dma_channel_configure((uint)rx_chan, &rc, &a->sink, &spi_get_hw(spi)->dr, 0, false);
+
+    /* One shared handler serves both SPI blocks */
+    if (max6921_hal_spi_async[spi_index ^ 1].rx_chan < 0) {
+        irq_add_shared_handler(DMA_IRQ_1, max6921_hal_spi_dma_irq,
+                               PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_1, true);
+    }
+    a->tx_chan = tx_chan;
+    a->rx_chan = rx_chan;
+    a->wide = wide;
+    dma_channel_set_irq1_enabled((uint)rx_chan, true);
+    return true;
+}
+
+static inline void max6921_hal_spi_async_deinit(uint8_t spi_index) {
+    max6921_hal_spi_async_t *a = &max6921_hal_spi_async[spi_index];
+    if (a->rx_chan < 0) {
+        return;
+    }
+
+    dma_channel_set_irq1_enabled((uint)a->rx_chan, false);
+    dma_channel_abort((uint)a->tx_chan);
+    dma_channel_abort((uint)a->rx_chan);
+    dma_channel_unclaim((uint)a->tx_chan);
+    dma_channel_unclaim((uint)a->rx_chan);
+    a->tx_chan = -1;
+    a->rx_chan = -1;
+
+    if (max6921_hal_spi_async[spi_index ^ 1].rx_chan < 0) {
+        irq_remove_handler(DMA_IRQ_1, max6921_hal_spi_dma_irq);
+    }
+}
+
+static inline void max6921_hal_spi_write_async(uint8_t spi_index, const uint8_t *data, size_t len,
+                                               max6921_hal_spi_done_t done, void *user_data) {
+    max6921_hal_spi_async_t *a = &max6921_hal_spi_async[spi_index];
+    spi_inst_t *spi = max6921_hal_spi_port(spi_index);
+
+    /* RX must only count this write's bytes */
+    while (spi_is_readable(spi)) {
+        (void)spi_get_hw(spi)->dr;
+    }
+    spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+
+    uint32_t count = a->wide ? (uint32_t)(len / 2) : (uint32_t)len;
+    a->done = done;
+    a->user_data = user_data;
+    dma_channel_set_trans_count((uint)a->rx_chan, count, true);
+    dma_channel_transfer_from_buffer_now((uint)a->tx_chan, data, count);
+}
+
+static inline void max6921_hal_gpio_init_output(uint8_t pin) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_OUT);
+}
+
+static inline void max6921_hal_gpio_put(uint8_t pin, bool value) {
+    gpio_put(pin, value);
+}
+
+static inline void max6921_hal_sleep_us(uint32_t us) {
+    sleep_us(us);
+}
+
+static inline void max6921_hal_sleep_until(uint64_t time_us) {
+    sleep_until(from_us_since_boot(time_us));
+}
+
+static inline void max6921_hal_busy_wait_us(uint32_t us) {
+    busy_wait_us_32(us);
+}
+
+static inline uint64_t max6921_hal_time_us(void) {
+    return time_us_64();
+}
+
+static inline uint32_t max6921_hal_time_us_32(void) {
+    return time_us_32();
+}
+
+static inline int32_t max6921_hal_alarm_at(uint64_t time_us,
+                                           max6921_hal_alarm_callback_t callback,
+                                           void *user_data) {
+    return add_alarm_at(from_us_since_boot(time_us), callback, user_data, true);
+}
+
+static inline void max6921_hal_alarm_cancel(int32_t id) {
+    cancel_alarm(id);
+}
+
+#endif /* MAX6921_HAL_PICO_H */